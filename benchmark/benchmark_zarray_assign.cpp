@@ -0,0 +1,79 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include "zarray/zarray.hpp"
+
+namespace xt
+{
+    namespace
+    {
+        xarray<double> bench_array()
+        {
+            xarray<double> a = xarray<double>::from_shape({1000, 1000});
+            a.fill(1.);
+            return a;
+        }
+    }
+
+    void xarray_copy_assign(benchmark::State& state)
+    {
+        xarray<double> a = bench_array();
+        xarray<double> b = bench_array();
+        for (auto _ : state)
+        {
+            a = b;
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(xarray_copy_assign);
+
+    void zarray_copy_assign(benchmark::State& state)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        zarray za(bench_array());
+        zarray zb(bench_array());
+        for (auto _ : state)
+        {
+            za = zb;
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(zarray_copy_assign);
+
+    void xarray_move_assign(benchmark::State& state)
+    {
+        xarray<double> a = bench_array();
+        xarray<double> b = bench_array();
+        for (auto _ : state)
+        {
+            a = std::move(b);
+            b = std::move(a);
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(xarray_move_assign);
+
+    void zarray_move_assign(benchmark::State& state)
+    {
+        zdispatcher_t<detail::xmove_dummy_functor, 1>::init();
+
+        zarray za(bench_array());
+        zarray zb(bench_array());
+        for (auto _ : state)
+        {
+            za = std::move(zb);
+            zb = std::move(za);
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(zarray_move_assign);
+}
@@ -0,0 +1,81 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include "zarray/zarray.hpp"
+
+namespace xt
+{
+    namespace
+    {
+        xarray<double> bench_array(const dynamic_shape<std::size_t>& shape)
+        {
+            xarray<double> a = xarray<double>::from_shape(shape);
+            a.fill(2.);
+            return a;
+        }
+    }
+
+    void xarray_row_broadcast(benchmark::State& state)
+    {
+        xarray<double> a = bench_array({1000, 1000});
+        xarray<double> row = bench_array({1000});
+        xarray<double> res = bench_array({1000, 1000});
+        for (auto _ : state)
+        {
+            res = a - row;
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(xarray_row_broadcast);
+
+    void zarray_row_broadcast(benchmark::State& state)
+    {
+        zdispatcher_t<detail::minus, 2>::init();
+
+        zarray za(bench_array({1000, 1000}));
+        zarray zrow(bench_array({1000}));
+        zarray zres(bench_array({1000, 1000}));
+        for (auto _ : state)
+        {
+            zres = za - zrow;
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(zarray_row_broadcast);
+
+    void xarray_column_broadcast(benchmark::State& state)
+    {
+        xarray<double> a = bench_array({1000, 1000});
+        xarray<double> column = bench_array({1000, 1});
+        xarray<double> res = bench_array({1000, 1000});
+        for (auto _ : state)
+        {
+            res = a / column;
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(xarray_column_broadcast);
+
+    void zarray_column_broadcast(benchmark::State& state)
+    {
+        zdispatcher_t<detail::divides, 2>::init();
+
+        zarray za(bench_array({1000, 1000}));
+        zarray zcolumn(bench_array({1000, 1}));
+        zarray zres(bench_array({1000, 1000}));
+        for (auto _ : state)
+        {
+            zres = za / zcolumn;
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(zarray_column_broadcast);
+}
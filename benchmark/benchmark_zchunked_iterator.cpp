@@ -0,0 +1,94 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include <benchmark/benchmark.h>
+
+#include <xtensor/xchunked_array.hpp>
+
+#include "zarray/zarray.hpp"
+
+namespace xt
+{
+    namespace
+    {
+        using shape_type = zarray::shape_type;
+
+        // 250000 chunks of 2x2 elements
+        shape_type bench_shape()
+        {
+            return {1000, 1000};
+        }
+
+        shape_type bench_chunk_shape()
+        {
+            return {2, 2};
+        }
+    }
+
+    void zchunked_iterator_traversal(benchmark::State& state)
+    {
+        auto a = chunked_array<double>(bench_shape(), bench_chunk_shape());
+        zarray za(a);
+        const zchunked_array& ca = za.as_chunked_array();
+        for (auto _ : state)
+        {
+            std::size_t n = 0;
+            for (auto it = ca.chunk_begin(); it != ca.chunk_end(); ++it)
+            {
+                n += it.chunk_index();
+            }
+            benchmark::DoNotOptimize(n);
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ca.grid_size()));
+    }
+    BENCHMARK(zchunked_iterator_traversal);
+
+    void zchunked_iterator_copy(benchmark::State& state)
+    {
+        auto a = chunked_array<double>(bench_shape(), bench_chunk_shape());
+        zarray za(a);
+        const zchunked_array& ca = za.as_chunked_array();
+        for (auto _ : state)
+        {
+            std::size_t n = 0;
+            for (auto it = ca.chunk_begin(); it != ca.chunk_end(); ++it)
+            {
+                zchunked_iterator copy = it;
+                n += copy.get_slice_vector().size();
+            }
+            benchmark::DoNotOptimize(n);
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(ca.grid_size()));
+    }
+    BENCHMARK(zchunked_iterator_copy);
+
+    void zchunked_noalias_assign(benchmark::State& state)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        auto a = chunked_array<double>(bench_shape(), bench_chunk_shape());
+        auto b = chunked_array<double>(bench_shape(), bench_chunk_shape());
+        auto res = chunked_array<double>(bench_shape(), bench_chunk_shape());
+        xarray<double> values = xarray<double>::from_shape(bench_shape());
+        values.fill(1.);
+        a = values;
+        b = values;
+        zarray za(a);
+        zarray zb(b);
+        zarray zres(res);
+        for (auto _ : state)
+        {
+            noalias(zres) = za + zb;
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(zres.as_chunked_array().grid_size()));
+    }
+    BENCHMARK(zchunked_noalias_assign);
+}
@@ -0,0 +1,723 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XTENSOR_ZAPPENDABLE_WRAPPER_HPP
+#define XTENSOR_ZAPPENDABLE_WRAPPER_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "zarray_zarray.hpp"
+#include "zchunked_view_wrapper.hpp"
+#include "zdispatcher.hpp"
+
+namespace xt
+{
+    /***********************
+     * zappendable_wrapper *
+     ***********************/
+
+    // Chunked array growing along one axis. The chunks are stored slab
+    // by slab along the append axis, so that appending values only
+    // allocates the chunks of the new slabs and writes to the chunks of
+    // the trailing slab; the other chunks are left untouched. Views over
+    // the array are invalidated when it grows.
+    template <class T>
+    class zappendable_wrapper : public ztyped_chunked_array<T>
+    {
+    public:
+
+        using self_type = zappendable_wrapper;
+        using base_type = ztyped_chunked_array<T>;
+        using value_type = T;
+        using shape_type = zchunked_array::shape_type;
+        using slice_vector = typename base_type::slice_vector;
+
+        template <class S>
+        zappendable_wrapper(const S& shape, const S& chunk_shape, std::size_t axis);
+
+        virtual ~zappendable_wrapper() = default;
+
+        std::size_t append_axis() const;
+        void append(const xarray<value_type>& values);
+
+        bool is_array() const override;
+        bool is_chunked() const override;
+        bool owns_buffer() const override;
+
+        xarray<value_type>& get_array() override;
+        const xarray<value_type>& get_array() const override;
+        xarray<value_type> get_chunk(const slice_vector& slices) const override;
+
+        self_type* clone() const override;
+        std::ostream& print(std::ostream& out) const override;
+
+        zarray_impl* strided_view(slice_vector& slices) override;
+
+        const nlohmann::json& get_metadata() const override;
+        void set_metadata(const nlohmann::json& metadata) override;
+        std::size_t dimension() const override;
+        const shape_type& shape() const override;
+        void reshape(const shape_type&) override;
+        void reshape(shape_type&&) override;
+        void resize(const shape_type& shape) override;
+        void resize(shape_type&& shape) override;
+        bool broadcast_shape(shape_type& shape, bool reuse_cache = 0) const override;
+
+        const shape_type& chunk_shape() const override;
+        size_t grid_size() const override;
+
+        const zchunk_grid& chunk_grid() const override;
+        zchunked_iterator chunk_begin() const override;
+        zchunked_iterator chunk_end() const override;
+
+        zchunk_traversal traversal_order() const override;
+        void set_traversal_order(zchunk_traversal order) override;
+
+        bool has_fill_value() const override;
+        bool is_fill_chunk(std::size_t index) const override;
+
+        bool has_chunk_statistics() const override;
+
+        bool has_aligned_chunks() const override;
+        std::size_t chunk_version(std::size_t index) const override;
+
+        bool is_incremental() const override;
+        void set_incremental(bool incremental) override;
+        bool is_chunk_up_to_date(std::size_t index, const std::vector<std::size_t>& input_key) const override;
+        void set_chunk_input_key(std::size_t index, std::vector<std::size_t>&& input_key) override;
+
+        void assign_chunk(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it) override;
+        xarray<value_type> read_chunk(const zchunked_iterator& chunk_it) const override;
+
+        void set_fill_value(const value_type& value) override;
+        const value_type& chunk_fill_value(std::size_t index) const override;
+        void assign_fill_chunk(const value_type& value, const zchunked_iterator& chunk_it) override;
+
+        void enable_chunk_statistics() override;
+        const zchunk_statistics<value_type>& chunk_statistics(std::size_t index) const override;
+
+    private:
+
+        zappendable_wrapper(const zappendable_wrapper&) = default;
+
+        void resize_extent(std::size_t extent);
+        std::size_t storage_index(const shape_type& coords) const;
+        std::size_t storage_index(std::size_t chunk_index) const;
+        shape_type storage_coords(std::size_t index) const;
+        void compute_cache() const;
+        void append_to_cache(const xarray<value_type>& values, std::size_t old_extent);
+
+        shape_type m_shape;
+        shape_type m_chunk_shape;
+        std::size_t m_axis;
+        zchunk_grid m_grid;
+        // Number of chunks in a slab orthogonal to the append axis
+        std::size_t m_slab_size;
+        // Chunks are stored slab by slab along the append axis
+        std::vector<xarray<value_type>> m_chunks;
+        std::vector<std::size_t> m_chunk_versions;
+        bool m_incremental;
+        std::vector<detail::zchunk_input_key> m_input_keys;
+        mutable xarray<value_type> m_cache;
+        mutable bool m_cache_initialized;
+        zmetadata<value_type> m_metadata;
+    };
+
+    template <class T, class S>
+    zarray appendable_chunked_array(const S& shape, const S& chunk_shape, std::size_t axis = 0);
+
+    void append(zarray& z, const zarray& values);
+
+    /*******************
+     * zappend_functor *
+     *******************/
+
+    namespace detail
+    {
+        struct xappend_dummy_functor {};
+
+        template <>
+        struct unary_dispatching_types<xappend_dummy_functor>
+        {
+            using type = zunary_all_ztypes_combinations_types;
+        };
+    }
+
+    struct zappend_functor
+    {
+        template <class T, class R>
+        static void run(const ztyped_array<T>& z, ztyped_array<R>& zres)
+        {
+            auto* appendable = dynamic_cast<zappendable_wrapper<R>*>(&zres);
+            if (appendable == nullptr)
+            {
+                throw std::runtime_error("append: array is not appendable");
+            }
+            appendable->append(xarray<R>(z.get_array()));
+        }
+
+        template <class T>
+        static size_t index(const ztyped_array<T>&)
+        {
+            return ztyped_array<T>::get_class_static_index();
+        }
+    };
+
+    template <>
+    struct get_zmapped_functor<detail::xappend_dummy_functor>
+    {
+        using type = zappend_functor;
+    };
+
+    using zappend_dispatcher = zdouble_dispatcher<detail::xappend_dummy_functor, mpl::vector<>>;
+
+    /**************************************
+     * zappendable_wrapper implementation *
+     **************************************/
+
+    template <class T>
+    template <class S>
+    inline zappendable_wrapper<T>::zappendable_wrapper(const S& shape, const S& chunk_shape, std::size_t axis)
+        : base_type()
+        , m_shape(shape.cbegin(), shape.cend())
+        , m_chunk_shape(chunk_shape.cbegin(), chunk_shape.cend())
+        , m_axis(axis)
+        , m_grid()
+        , m_slab_size(1u)
+        , m_chunks()
+        , m_chunk_versions()
+        , m_incremental(false)
+        , m_input_keys()
+        , m_cache()
+        , m_cache_initialized(false)
+    {
+        if (m_shape.size() != m_chunk_shape.size() || axis >= m_shape.size())
+        {
+            throw std::runtime_error("appendable chunked array: invalid shape, chunk shape or axis");
+        }
+        for (std::size_t d = 0; d < m_shape.size(); ++d)
+        {
+            if (d != m_axis)
+            {
+                m_slab_size *= (m_shape[d] + m_chunk_shape[d] - 1) / m_chunk_shape[d];
+            }
+        }
+        std::size_t extent = m_shape[m_axis];
+        m_shape[m_axis] = 0;
+        m_grid = zchunk_grid(m_shape, m_chunk_shape);
+        resize_extent(extent);
+    }
+
+    template <class T>
+    std::size_t zappendable_wrapper<T>::append_axis() const
+    {
+        return m_axis;
+    }
+
+    // Appends values along the append axis; values must have the shape
+    // of the array, except along the append axis.
+    template <class T>
+    void zappendable_wrapper<T>::append(const xarray<value_type>& values)
+    {
+        this->update_version();
+        const auto& values_shape = values.shape();
+        bool valid = values_shape.size() == m_shape.size();
+        for (std::size_t d = 0; valid && d < m_shape.size(); ++d)
+        {
+            valid = d == m_axis || values_shape[d] == m_shape[d];
+        }
+        if (!valid)
+        {
+            throw std::runtime_error("append: shape mismatch");
+        }
+
+        std::size_t old_extent = m_shape[m_axis];
+        std::size_t chunk_size = m_chunk_shape[m_axis];
+        resize_extent(old_extent + values_shape[m_axis]);
+        if (m_cache_initialized)
+        {
+            append_to_cache(values, old_extent);
+        }
+
+        // Only the chunks of the slabs intersecting the appended values are written
+        std::size_t dim = m_shape.size();
+        xstrided_slice_vector chunk_slices(dim), values_slices(dim);
+        for (std::size_t index = old_extent / chunk_size * m_slab_size; index < m_chunks.size(); ++index)
+        {
+            shape_type coords = storage_coords(index);
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                std::size_t start = m_grid.chunk_start(d, coords[d]);
+                std::size_t stop = m_grid.chunk_stop(d, coords[d]);
+                std::size_t lo = d == m_axis ? (std::max)(start, old_extent) : start;
+                std::size_t origin = d == m_axis ? old_extent : std::size_t(0);
+                chunk_slices[d] = xt::range(lo - start, stop - start);
+                values_slices[d] = xt::range(lo - origin, stop - origin);
+            }
+            xt::noalias(xt::strided_view(m_chunks[index], chunk_slices)) = xt::strided_view(values, values_slices);
+        }
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::is_array() const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::is_chunked() const
+    {
+        return true;
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::owns_buffer() const
+    {
+        return false;
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::get_array() -> xarray<value_type>&
+    {
+        this->update_version();
+        compute_cache();
+        return m_cache;
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::get_array() const -> const xarray<value_type>&
+    {
+        compute_cache();
+        return m_cache;
+    }
+
+    // See zchunked_wrapper::get_chunk
+    template <class T>
+    auto zappendable_wrapper<T>::get_chunk(const slice_vector& slices) const -> xarray<value_type>
+    {
+        xarray<value_type> res;
+        if (!m_cache_initialized && detail::read_chunked_box(*this, slices, res))
+        {
+            return res;
+        }
+        compute_cache();
+        return xt::strided_view(m_cache, slices);
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::clone() const -> self_type*
+    {
+        return new self_type(*this);
+    }
+
+    template <class T>
+    std::ostream& zappendable_wrapper<T>::print(std::ostream& out) const
+    {
+        return out << get_array();
+    }
+
+    template <class T>
+    zarray_impl* zappendable_wrapper<T>::strided_view(slice_vector& slices)
+    {
+        this->update_version();
+        zarray_impl* view = detail::build_chunked_view<value_type>(*this, slices);
+        if (view != nullptr)
+        {
+            return view;
+        }
+        auto e = xt::strided_view(get_array(), slices);
+        return detail::build_zarray(std::move(e));
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::get_metadata() const -> const nlohmann::json&
+    {
+        return m_metadata.get();
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::set_metadata(const nlohmann::json& metadata)
+    {
+        m_metadata.set(metadata);
+    }
+
+    template <class T>
+    std::size_t zappendable_wrapper<T>::dimension() const
+    {
+        return m_shape.size();
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::shape() const -> const shape_type&
+    {
+        return m_shape;
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::reshape(const shape_type&)
+    {
+        // No op
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::reshape(shape_type&&)
+    {
+        // No op
+    }
+
+    // Unlike other chunked arrays, the extent along the append axis
+    // follows the shape of the assigned expressions.
+    template <class T>
+    void zappendable_wrapper<T>::resize(const shape_type& shape)
+    {
+        this->update_version();
+        bool valid = shape.size() == m_shape.size();
+        for (std::size_t d = 0; valid && d < m_shape.size(); ++d)
+        {
+            valid = d == m_axis || shape[d] == m_shape[d];
+        }
+        if (!valid)
+        {
+            throw std::runtime_error("appendable chunked array can only be resized along its append axis");
+        }
+        if (shape[m_axis] != m_shape[m_axis])
+        {
+            resize_extent(shape[m_axis]);
+            m_cache_initialized = false;
+        }
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::resize(shape_type&& shape)
+    {
+        resize(static_cast<const shape_type&>(shape));
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::broadcast_shape(shape_type& shape, bool) const
+    {
+        return xt::broadcast_shape(m_shape, shape);
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::chunk_shape() const -> const shape_type&
+    {
+        return m_chunk_shape;
+    }
+
+    template <class T>
+    size_t zappendable_wrapper<T>::grid_size() const
+    {
+        return m_grid.size();
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::chunk_grid() const -> const zchunk_grid&
+    {
+        return m_grid;
+    }
+
+    template <class T>
+    zchunked_iterator zappendable_wrapper<T>::chunk_begin() const
+    {
+        return zchunked_iterator(m_grid, 0u);
+    }
+
+    template <class T>
+    zchunked_iterator zappendable_wrapper<T>::chunk_end() const
+    {
+        return zchunked_iterator(m_grid, m_grid.size());
+    }
+
+    template <class T>
+    zchunk_traversal zappendable_wrapper<T>::traversal_order() const
+    {
+        return m_grid.traversal();
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::set_traversal_order(zchunk_traversal order)
+    {
+        m_grid.set_traversal(order);
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::has_fill_value() const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::is_fill_chunk(std::size_t) const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::has_chunk_statistics() const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::has_aligned_chunks() const
+    {
+        return true;
+    }
+
+    template <class T>
+    std::size_t zappendable_wrapper<T>::chunk_version(std::size_t index) const
+    {
+        return m_chunk_versions[storage_index(index)];
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::is_incremental() const
+    {
+        return m_incremental;
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::set_incremental(bool incremental)
+    {
+        m_incremental = incremental;
+        if (incremental)
+        {
+            m_input_keys.assign(m_chunks.size(), detail::zchunk_input_key{{}, 0u});
+        }
+        else
+        {
+            m_input_keys.clear();
+        }
+    }
+
+    template <class T>
+    bool zappendable_wrapper<T>::is_chunk_up_to_date(std::size_t index, const std::vector<std::size_t>& input_key) const
+    {
+        std::size_t i = storage_index(index);
+        const detail::zchunk_input_key& key = m_input_keys[i];
+        return key.version == m_chunk_versions[i] && key.inputs == input_key;
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::set_chunk_input_key(std::size_t index, std::vector<std::size_t>&& input_key)
+    {
+        std::size_t i = storage_index(index);
+        m_input_keys[i] = detail::zchunk_input_key{std::move(input_key), m_chunk_versions[i]};
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::assign_chunk(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it)
+    {
+        this->update_version();
+        std::size_t index = storage_index(chunk_it.chunk_coords());
+        if (rhs.shape() == m_chunks[index].shape())
+        {
+            m_chunks[index] = std::move(rhs);
+        }
+        else
+        {
+            xt::noalias(xt::strided_view(m_chunks[index], chunk_it.get_chunk_slice_vector())) = rhs;
+        }
+        m_chunk_versions[index] = detail::next_chunk_version();
+        m_cache_initialized = false;
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::read_chunk(const zchunked_iterator& chunk_it) const -> xarray<value_type>
+    {
+        const xarray<value_type>& chunk = m_chunks[storage_index(chunk_it.chunk_coords())];
+        return xt::strided_view(chunk, chunk_it.get_chunk_slice_vector());
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::set_fill_value(const value_type& value)
+    {
+        this->update_version();
+        auto chunk_end = this->chunk_end();
+        for (auto it = this->chunk_begin(); it != chunk_end; ++it)
+        {
+            assign_fill_chunk(value, it);
+        }
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::chunk_fill_value(std::size_t) const -> const value_type&
+    {
+        throw std::runtime_error("appendable chunked array does not track fill chunks");
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::assign_fill_chunk(const value_type& value, const zchunked_iterator& chunk_it)
+    {
+        this->update_version();
+        std::size_t index = storage_index(chunk_it.chunk_coords());
+        m_chunks[index].fill(value);
+        m_chunk_versions[index] = detail::next_chunk_version();
+        m_cache_initialized = false;
+    }
+
+    template <class T>
+    void zappendable_wrapper<T>::enable_chunk_statistics()
+    {
+        throw std::runtime_error("appendable chunked array does not maintain chunk statistics");
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::chunk_statistics(std::size_t) const -> const zchunk_statistics<value_type>&
+    {
+        throw std::runtime_error("appendable chunked array does not maintain chunk statistics");
+    }
+
+    // Allocates or releases whole slabs; the chunks of the slab where
+    // the extent changes get a new version. The new chunks are allocated
+    // and the grid is resized before the array is modified, so that a
+    // failure leaves it unchanged. The grid grows in place, without
+    // recomputing the traversal order of the existing chunks.
+    template <class T>
+    void zappendable_wrapper<T>::resize_extent(std::size_t extent)
+    {
+        std::size_t old_extent = m_shape[m_axis];
+        if (extent == old_extent && !m_chunks.empty())
+        {
+            return;
+        }
+        std::size_t chunk_size = m_chunk_shape[m_axis];
+        std::size_t nb_chunks = (extent + chunk_size - 1) / chunk_size * m_slab_size;
+        std::size_t first_changed = (std::min)(old_extent, extent) / chunk_size * m_slab_size;
+        std::vector<xarray<value_type>> new_chunks;
+        for (std::size_t i = m_chunks.size(); i < nb_chunks; ++i)
+        {
+            new_chunks.push_back(xarray<value_type>::from_shape(m_chunk_shape));
+        }
+        m_chunks.reserve(nb_chunks);
+        m_chunk_versions.reserve(nb_chunks);
+        if (m_incremental)
+        {
+            m_input_keys.reserve(nb_chunks);
+        }
+        m_grid.resize(m_axis, extent);
+
+        m_shape[m_axis] = extent;
+        m_chunks.resize((std::min)(m_chunks.size(), nb_chunks));
+        m_chunk_versions.resize(m_chunks.size());
+        for (std::size_t i = first_changed; i < m_chunks.size(); ++i)
+        {
+            m_chunk_versions[i] = detail::next_chunk_version();
+        }
+        for (auto& chunk : new_chunks)
+        {
+            m_chunks.push_back(std::move(chunk));
+            m_chunk_versions.push_back(detail::next_chunk_version());
+        }
+        if (m_incremental)
+        {
+            m_input_keys.resize(m_chunks.size(), detail::zchunk_input_key{{}, 0u});
+        }
+    }
+
+    template <class T>
+    std::size_t zappendable_wrapper<T>::storage_index(const shape_type& coords) const
+    {
+        const auto& grid_shape = m_grid.grid_shape();
+        std::size_t res = 0;
+        for (std::size_t d = 0; d < coords.size(); ++d)
+        {
+            if (d != m_axis)
+            {
+                res = res * grid_shape[d] + coords[d];
+            }
+        }
+        return coords[m_axis] * m_slab_size + res;
+    }
+
+    template <class T>
+    std::size_t zappendable_wrapper<T>::storage_index(std::size_t chunk_index) const
+    {
+        const auto& grid_shape = m_grid.grid_shape();
+        shape_type coords(m_shape.size());
+        for (std::size_t d = coords.size(); d != 0; --d)
+        {
+            coords[d - 1] = chunk_index % grid_shape[d - 1];
+            chunk_index /= grid_shape[d - 1];
+        }
+        return storage_index(coords);
+    }
+
+    template <class T>
+    auto zappendable_wrapper<T>::storage_coords(std::size_t index) const -> shape_type
+    {
+        const auto& grid_shape = m_grid.grid_shape();
+        shape_type res(m_shape.size());
+        res[m_axis] = index / m_slab_size;
+        index %= m_slab_size;
+        for (std::size_t d = m_shape.size(); d != 0; --d)
+        {
+            if (d - 1 != m_axis)
+            {
+                res[d - 1] = index % grid_shape[d - 1];
+                index /= grid_shape[d - 1];
+            }
+        }
+        return res;
+    }
+
+    template <class T>
+    inline void zappendable_wrapper<T>::compute_cache() const
+    {
+        if (!m_cache_initialized)
+        {
+            m_cache.resize(m_shape);
+            auto chunk_end = this->chunk_end();
+            for (auto it = this->chunk_begin(); it != chunk_end; ++it)
+            {
+                xt::noalias(xt::strided_view(m_cache, it.get_slice_vector())) = read_chunk(it);
+            }
+            m_cache_initialized = true;
+        }
+    }
+
+    // The cache is extended with the appended values instead of being
+    // rebuilt from the chunks
+    template <class T>
+    inline void zappendable_wrapper<T>::append_to_cache(const xarray<value_type>& values, std::size_t old_extent)
+    {
+        xarray<value_type> cache = xarray<value_type>::from_shape(m_shape);
+        xstrided_slice_vector slices(m_shape.size(), xt::all());
+        slices[m_axis] = xt::range(std::size_t(0), old_extent);
+        xt::noalias(xt::strided_view(cache, slices)) = m_cache;
+        slices[m_axis] = xt::range(old_extent, m_shape[m_axis]);
+        xt::noalias(xt::strided_view(cache, slices)) = values;
+        m_cache = std::move(cache);
+    }
+
+    /***************************************
+     * appendable_chunked_array and append *
+     ***************************************/
+
+    // Creates a chunked array that can grow along the given axis.
+    // The initial extent along that axis is usually 0.
+    template <class T, class S>
+    inline zarray appendable_chunked_array(const S& shape, const S& chunk_shape, std::size_t axis)
+    {
+        zarray::implementation_ptr p(new zappendable_wrapper<T>(shape, chunk_shape, axis));
+        return zarray(std::move(p));
+    }
+
+    // Appends values to an array created with appendable_chunked_array,
+    // converting them to its value type
+    inline void append(zarray& z, const zarray& values)
+    {
+        zappend_dispatcher::dispatch(values.get_implementation(), z.get_implementation());
+    }
+}
+
+#endif
@@ -22,6 +22,10 @@
 #include "zwrappers.hpp"
 #include "zinit.hpp"
 #include "zarray_zarray.hpp"
+#include "zrechunk.hpp"
+#include "zchunk_pipeline.hpp"
+#include "zappendable_wrapper.hpp"
+#include "zresult_cache.hpp"
 #include "zarray/zreducer.hpp"
 #include "zarray/zreducer_options.hpp"
 #include "zarray/zreducers.hpp"
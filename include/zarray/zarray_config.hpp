@@ -14,5 +14,104 @@
 #define ZARRAY_VERSION_MINOR 1
 #define ZARRAY_VERSION_PATCH 0
 
+// Allows rewrites of expressions that change the rounding of floating
+// point results, such as the folding of scalar chains: a * 2. * 3.
+// is then evaluated as a * 6.
+#ifndef ZARRAY_FAST_MATH
+#define ZARRAY_FAST_MATH 0
+#endif
+
+// Allows the contraction of a * b + c into a fused multiply-add. It
+// saves a temporary and a pass over memory, but the result is computed
+// with a single rounding and can differ from the one of a * b + c.
+#ifndef ZARRAY_FP_CONTRACT
+#define ZARRAY_FP_CONTRACT 0
+#endif
+
+// Set by the targets of the zarray compiled library: the dispatchers
+// of the built-in functions and the register of implementations are
+// instantiated in the library, translation units only see declarations
+#ifndef ZARRAY_COMPILED_LIBRARY
+#define ZARRAY_COMPILED_LIBRARY 0
+#endif
+
+#if ZARRAY_COMPILED_LIBRARY
+#define ZARRAY_LIBRARY_INLINE
+#else
+#define ZARRAY_LIBRARY_INLINE inline
+#endif
+
+// Value types dispatched by zarray: the kernels of a disabled type
+// are not instantiated and it is not in the register of
+// implementations. bool, the result type of comparisons, is always
+// enabled.
+#ifndef ZARRAY_ENABLE_UINT8
+#define ZARRAY_ENABLE_UINT8 1
+#endif
+#ifndef ZARRAY_ENABLE_INT8
+#define ZARRAY_ENABLE_INT8 1
+#endif
+#ifndef ZARRAY_ENABLE_UINT16
+#define ZARRAY_ENABLE_UINT16 1
+#endif
+#ifndef ZARRAY_ENABLE_INT16
+#define ZARRAY_ENABLE_INT16 1
+#endif
+#ifndef ZARRAY_ENABLE_UINT32
+#define ZARRAY_ENABLE_UINT32 1
+#endif
+#ifndef ZARRAY_ENABLE_INT32
+#define ZARRAY_ENABLE_INT32 1
+#endif
+#ifndef ZARRAY_ENABLE_UINT64
+#define ZARRAY_ENABLE_UINT64 1
+#endif
+#ifndef ZARRAY_ENABLE_INT64
+#define ZARRAY_ENABLE_INT64 1
+#endif
+#ifndef ZARRAY_ENABLE_FLOAT
+#define ZARRAY_ENABLE_FLOAT 1
+#endif
+#ifndef ZARRAY_ENABLE_DOUBLE
+#define ZARRAY_ENABLE_DOUBLE 1
+#endif
+
+// Compiles the tracing hooks of the kernels, temporary buffers, chunks
+// and reducers, which record events when the ztracer is enabled
+#ifndef ZARRAY_TRACING
+#define ZARRAY_TRACING 0
+#endif
+
+// Op families whose dispatchers can be initialized by init_zdispatchers
+#define ZARRAY_ASSIGN_OPS 0x0001u
+#define ZARRAY_ARITHMETIC_OPS 0x0002u
+#define ZARRAY_LOGICAL_OPS 0x0004u
+#define ZARRAY_BITWISE_OPS 0x0008u
+#define ZARRAY_COMPARISON_OPS 0x0010u
+#define ZARRAY_BASIC_MATH_OPS 0x0020u
+#define ZARRAY_EXP_OPS 0x0040u
+#define ZARRAY_POWER_OPS 0x0080u
+#define ZARRAY_TRIGONOMETRIC_OPS 0x0100u
+#define ZARRAY_HYPERBOLIC_OPS 0x0200u
+#define ZARRAY_ERF_OPS 0x0400u
+#define ZARRAY_GAMMA_OPS 0x0800u
+#define ZARRAY_ROUNDING_OPS 0x1000u
+#define ZARRAY_CLASSIFICATION_OPS 0x2000u
+#define ZARRAY_REDUCER_OPS 0x4000u
+
+#define ZARRAY_OPERATOR_OPS \
+    (ZARRAY_ASSIGN_OPS | ZARRAY_ARITHMETIC_OPS | ZARRAY_LOGICAL_OPS | ZARRAY_BITWISE_OPS | ZARRAY_COMPARISON_OPS)
+#define ZARRAY_MATH_OPS \
+    (ZARRAY_BASIC_MATH_OPS | ZARRAY_EXP_OPS | ZARRAY_POWER_OPS | ZARRAY_TRIGONOMETRIC_OPS | ZARRAY_HYPERBOLIC_OPS | \
+     ZARRAY_ERF_OPS | ZARRAY_GAMMA_OPS | ZARRAY_ROUNDING_OPS | ZARRAY_CLASSIFICATION_OPS)
+#define ZARRAY_ALL_OPS (ZARRAY_OPERATOR_OPS | ZARRAY_MATH_OPS | ZARRAY_REDUCER_OPS)
+
+// Op families initialized by init_zsystem and instantiated in the
+// compiled library. The dispatchers of the other families are built
+// on their first dispatch.
+#ifndef ZARRAY_OP_FAMILIES
+#define ZARRAY_OP_FAMILIES ZARRAY_ALL_OPS
+#endif
+
 #endif
 
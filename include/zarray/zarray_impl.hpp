@@ -10,6 +10,11 @@
 #ifndef XTENSOR_ZARRAY_IMPL_HPP
 #define XTENSOR_ZARRAY_IMPL_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <tuple>
+
 #include <nlohmann/json.hpp>
 
 #include <xtl/xplatform.hpp>
@@ -39,6 +44,18 @@ namespace xt
     template <class CTE>
     class zexpression_wrapper;
 
+    template <class T>
+    class zlazy_wrapper;
+
+    class zlazy_expression;
+
+    struct zassign_args;
+
+    namespace detail
+    {
+        class zarray_temporary_pool;
+    }
+
     /******************
      * zarray builder *
      ******************/
@@ -154,6 +171,15 @@ namespace xt
      * zarray_impl *
      ***************/
 
+    namespace detail
+    {
+        inline std::size_t next_impl_version()
+        {
+            static std::atomic<std::size_t> version(0);
+            return ++version;
+        }
+    }
+
     class zarray_impl
     {
     public:
@@ -172,6 +198,9 @@ namespace xt
 
         virtual bool is_array() const = 0;
         virtual bool is_chunked() const = 0;
+        // True when the implementation is a dense array owning its data,
+        // which can be overwritten when the zarray is a temporary
+        virtual bool owns_buffer() const = 0;
 
         virtual self_type* strided_view(xstrided_slice_vector& slices) = 0;
 
@@ -186,14 +215,71 @@ namespace xt
         virtual void resize(shape_type&& shape) = 0;
         virtual bool broadcast_shape(shape_type& shape, bool reuse_cache = 0) const = 0;
 
+        // Both implementations must be dense arrays with the same
+        // class index, these methods skip the dispatching
+        virtual void copy_array(const zarray_impl& rhs) = 0;
+        virtual void move_array(zarray_impl& rhs) = 0;
+
+        // Lazy zarrays return their expression until it is evaluated
+        virtual const zlazy_expression* get_lazy_expression() const;
+        // Lazy zarrays evaluate their expression in the temporary pool of
+        // an expression they are an operand of and keep the result; the
+        // returned input is the buffer of the result in the pool. Other
+        // implementations, and evaluated lazy zarrays, return themselves.
+        virtual std::tuple<const zarray_impl*, bool>
+        evaluate_lazy_expression(detail::zarray_temporary_pool& temporary_pool, const zassign_args& args) const;
+
+        // The version is taken from a process-wide counter when the
+        // implementation is built and each time its data may be modified:
+        // the mutating methods of the wrappers (non-const get_array,
+        // resize, assign_chunk, append...) renew it, so two states of
+        // data never share a version.
+        std::size_t version() const;
+        void update_version();
+
         XTL_IMPLEMENT_INDEXABLE_CLASS()
 
     protected:
 
-        zarray_impl() = default;
-        zarray_impl(const zarray_impl&) = default;
+        zarray_impl();
+        zarray_impl(const zarray_impl&);
+
+    private:
+
+        std::size_t m_version;
     };
 
+    inline zarray_impl::zarray_impl()
+        : m_version(detail::next_impl_version())
+    {
+    }
+
+    inline zarray_impl::zarray_impl(const zarray_impl&)
+        : m_version(detail::next_impl_version())
+    {
+    }
+
+    inline std::size_t zarray_impl::version() const
+    {
+        return m_version;
+    }
+
+    inline void zarray_impl::update_version()
+    {
+        m_version = detail::next_impl_version();
+    }
+
+    inline const zlazy_expression* zarray_impl::get_lazy_expression() const
+    {
+        return nullptr;
+    }
+
+    inline std::tuple<const zarray_impl*, bool>
+    zarray_impl::evaluate_lazy_expression(detail::zarray_temporary_pool&, const zassign_args&) const
+    {
+        return std::make_tuple(this, false);
+    }
+
     /****************
      * ztyped_array *
      ****************/
@@ -213,6 +299,13 @@ namespace xt
         virtual const xarray<T>& get_array() const = 0;
         virtual xarray<T> get_chunk(const slice_vector& slices) const = 0;
 
+        // Scalar operands of expressions return the address of their
+        // value, so that kernels do not go through the 0-D array
+        virtual const T* scalar_value() const;
+
+        void copy_array(const zarray_impl& rhs) override;
+        void move_array(zarray_impl& rhs) override;
+
         XTL_IMPLEMENT_INDEXABLE_CLASS()
 
     protected:
@@ -221,6 +314,45 @@ namespace xt
         ztyped_array(const ztyped_array&) = default;
     };
 
+    /*******************************
+     * ztyped_array implementation *
+     *******************************/
+
+    template <class T>
+    inline const T* ztyped_array<T>::scalar_value() const
+    {
+        return nullptr;
+    }
+
+    // xarray buffers are contiguous: the copy reuses the capacity of the
+    // destination and boils down to a memcpy for trivially copyable types
+    template <class T>
+    inline void ztyped_array<T>::copy_array(const zarray_impl& rhs)
+    {
+        const xarray<T>& src = static_cast<const ztyped_array<T>&>(rhs).get_array();
+        xarray<T>& dst = get_array();
+        if (&src != &dst)
+        {
+            if (dst.shape() != src.shape())
+            {
+                dst.resize(src.shape());
+            }
+            std::copy(src.storage().cbegin(), src.storage().cend(), dst.storage().begin());
+        }
+    }
+
+    // The buffer of rhs is moved, only pointers are exchanged
+    template <class T>
+    inline void ztyped_array<T>::move_array(zarray_impl& rhs)
+    {
+        xarray<T>& src = static_cast<ztyped_array<T>&>(rhs).get_array();
+        xarray<T>& dst = get_array();
+        if (&src != &dst)
+        {
+            dst = std::move(src);
+        }
+    }
+
     /*****************
      * set_data_type *
      *****************/
@@ -310,6 +442,90 @@ namespace xt
             metadata["data_type"] = endianness_string() + "f8";
         }
     }
+
+    /*************
+     * zmetadata *
+     *************/
+
+    // The metadata of the wrappers are built on first access,
+    // temporaries and scalars of expressions never allocate them.
+    // get() may be called concurrently, for instance by the threads
+    // of the chunk pipeline: the first access builds the metadata
+    // under a lock, the next ones only read the atomic flag.
+    template <class T>
+    class zmetadata
+    {
+    public:
+
+        zmetadata();
+        zmetadata(const zmetadata& rhs);
+        zmetadata& operator=(const zmetadata& rhs);
+
+        const nlohmann::json& get() const;
+        void set(const nlohmann::json& metadata);
+
+    private:
+
+        mutable nlohmann::json m_metadata;
+        mutable std::atomic<bool> m_initialized;
+        mutable std::mutex m_mutex;
+    };
+
+    template <class T>
+    inline zmetadata<T>::zmetadata()
+        : m_metadata()
+        , m_initialized(false)
+        , m_mutex()
+    {
+    }
+
+    template <class T>
+    inline zmetadata<T>::zmetadata(const zmetadata& rhs)
+        : m_metadata()
+        , m_initialized(false)
+        , m_mutex()
+    {
+        *this = rhs;
+    }
+
+    template <class T>
+    inline zmetadata<T>& zmetadata<T>::operator=(const zmetadata& rhs)
+    {
+        if (this != &rhs)
+        {
+            // rhs may be building or setting its metadata in another thread
+            std::lock(m_mutex, rhs.m_mutex);
+            std::lock_guard<std::mutex> lock(m_mutex, std::adopt_lock);
+            std::lock_guard<std::mutex> rhs_lock(rhs.m_mutex, std::adopt_lock);
+            bool initialized = rhs.m_initialized.load(std::memory_order_relaxed);
+            m_metadata = initialized ? rhs.m_metadata : nlohmann::json();
+            m_initialized.store(initialized, std::memory_order_release);
+        }
+        return *this;
+    }
+
+    template <class T>
+    inline const nlohmann::json& zmetadata<T>::get() const
+    {
+        if (!m_initialized.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_initialized.load(std::memory_order_relaxed))
+            {
+                detail::set_data_type<T>(m_metadata);
+                m_initialized.store(true, std::memory_order_release);
+            }
+        }
+        return m_metadata;
+    }
+
+    template <class T>
+    inline void zmetadata<T>::set(const nlohmann::json& metadata)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_metadata = metadata;
+        m_initialized.store(true, std::memory_order_release);
+    }
 }
 
 #endif
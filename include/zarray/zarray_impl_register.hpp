@@ -1,7 +1,12 @@
 #ifndef XTENSOR_ZARRAY_IMPL_REGISTER_HPP
 #define XTENSOR_ZARRAY_IMPL_REGISTER_HPP
 
+#include <functional>
+#include <string>
+
+#include "zarray_config.hpp"
 #include "zarray_impl.hpp"
+#include "zlazy_wrapper.hpp"
 
 namespace xt
 {
@@ -13,11 +18,30 @@ namespace xt
     {
     public:
 
+        using shape_type = zarray_impl::shape_type;
+        using chunked_factory = std::function<zarray_impl*(const shape_type&, const shape_type&)>;
+        using lazy_factory = zarray_impl* (*)(zlazy_expression*);
+
         template <class T>
         static void insert();
 
         static void init();
         static const zarray_impl& get(size_t index);
+        static size_t value_size(size_t index);
+        // data type of the metadata of the implementation, e.g. "<f8"
+        static const std::string& data_type(size_t index);
+
+        // Chunked arrays of value type T built for the results of
+        // expressions over chunked operands are in-memory chunked
+        // arrays, unless another factory is set (for instance to
+        // store the results on disk).
+        template <class T>
+        static void set_chunked_factory(chunked_factory factory);
+        static zarray_impl* make_chunked(size_t index, const shape_type& shape, const shape_type& chunk_shape);
+
+        // Builds a lazy zarray implementation taking
+        // the ownership of the expression
+        static zarray_impl* make_lazy(size_t index, zlazy_expression* e);
 
     private:
 
@@ -31,8 +55,28 @@ namespace xt
 
         size_t m_next_index;
         std::vector<std::unique_ptr<zarray_impl>> m_register;
+        std::vector<size_t> m_value_sizes;
+        std::vector<std::string> m_data_types;
+        std::vector<chunked_factory> m_chunked_factories;
+        std::vector<lazy_factory> m_lazy_factories;
     };
 
+    namespace detail
+    {
+        template <class T>
+        inline zarray_impl* build_chunked_result(const zarray_impl::shape_type& shape,
+                                                 const zarray_impl::shape_type& chunk_shape)
+        {
+            return build_zarray(chunked_array<T>(shape, chunk_shape));
+        }
+
+        template <class T>
+        inline zarray_impl* build_lazy_result(zlazy_expression* e)
+        {
+            return new zlazy_wrapper<T>(e);
+        }
+    }
+
 
     /***************************************
      * zarray_impl_register implementation *
@@ -54,32 +98,83 @@ namespace xt
         return *(instance().m_register[index]);
     }
 
-    inline zarray_impl_register& zarray_impl_register::instance()
+    inline size_t zarray_impl_register::value_size(size_t index)
+    {
+        return instance().m_value_sizes[index];
+    }
+
+    inline const std::string& zarray_impl_register::data_type(size_t index)
+    {
+        return instance().m_data_types[index];
+    }
+
+    template <class T>
+    inline void zarray_impl_register::set_chunked_factory(chunked_factory factory)
+    {
+        zarray_impl_register& r = instance();
+        r.template insert_impl<T>();
+        r.m_chunked_factories[ztyped_array<T>::get_class_static_index()] = std::move(factory);
+    }
+
+    inline zarray_impl* zarray_impl_register::make_chunked(size_t index, const shape_type& shape, const shape_type& chunk_shape)
+    {
+        return instance().m_chunked_factories[index](shape, chunk_shape);
+    }
+
+    inline zarray_impl* zarray_impl_register::make_lazy(size_t index, zlazy_expression* e)
+    {
+        return instance().m_lazy_factories[index](e);
+    }
+
+    // The register is built in the compiled library when it is used
+#if !ZARRAY_COMPILED_LIBRARY || defined(ZARRAY_LIBRARY_SOURCE)
+    ZARRAY_LIBRARY_INLINE zarray_impl_register& zarray_impl_register::instance()
     {
         static zarray_impl_register r;
         return r;
     }
 
-    inline zarray_impl_register::zarray_impl_register()
+    ZARRAY_LIBRARY_INLINE zarray_impl_register::zarray_impl_register()
         : m_next_index(0)
     {
 
         insert_impl<bool>();
 
+#if ZARRAY_ENABLE_UINT8
         insert_impl<uint8_t>();
+#endif
+#if ZARRAY_ENABLE_UINT16
         insert_impl<uint16_t>();
+#endif
+#if ZARRAY_ENABLE_UINT32
         insert_impl<uint32_t>();
+#endif
+#if ZARRAY_ENABLE_UINT64
         insert_impl<uint64_t>();
+#endif
 
+#if ZARRAY_ENABLE_INT8
         insert_impl<int8_t>();
+#endif
+#if ZARRAY_ENABLE_INT16
         insert_impl<int16_t>();
+#endif
+#if ZARRAY_ENABLE_INT32
         insert_impl<int32_t>();
+#endif
+#if ZARRAY_ENABLE_INT64
         insert_impl<int64_t>();
+#endif
 
+#if ZARRAY_ENABLE_FLOAT
         insert_impl<float>();
+#endif
+#if ZARRAY_ENABLE_DOUBLE
         insert_impl<double>();
+#endif
 
     }
+#endif
 
     template <class T>
     inline void zarray_impl_register::insert_impl()
@@ -96,6 +191,25 @@ namespace xt
             m_register.resize(idx + 1u);
         }
         m_register[idx] = std::unique_ptr<zarray_impl>(detail::build_zarray(std::move(xarray<T>())));
+        m_value_sizes.resize(m_register.size());
+        m_value_sizes[idx] = sizeof(T);
+        nlohmann::json metadata;
+        detail::set_data_type<T>(metadata);
+        m_data_types.resize(m_register.size());
+        m_data_types[idx] = metadata.is_null() ? std::string() : metadata["data_type"].get<std::string>();
+        if (m_chunked_factories.size() <= idx)
+        {
+            m_chunked_factories.resize(idx + 1u);
+        }
+        if (!m_chunked_factories[idx])
+        {
+            m_chunked_factories[idx] = &detail::build_chunked_result<T>;
+        }
+        if (m_lazy_factories.size() <= idx)
+        {
+            m_lazy_factories.resize(idx + 1u);
+        }
+        m_lazy_factories[idx] = &detail::build_lazy_result<T>;
     }
 
 }
@@ -11,9 +11,14 @@
 #define XTENSOR_ZARRAY_TEMPORARY_POOL_HPP
 
 #include <array>
+#include <functional>
 #include <set>
 #include <map>
 #include <memory>
+#include <numeric>
+#include <vector>
+
+#include "ztracer.hpp"
 
 namespace xt
 {
@@ -26,24 +31,49 @@ namespace xt
         {
         public:
             using shape_type = typename zarray_impl::shape_type;
+            using key_type = std::vector<std::size_t>;
 
             explicit zarray_temporary_pool(zarray_impl & res)
             :   m_shape(res.shape()),
+                p_result(&res),
                 m_buffers(),
-                m_free_buffers()
+                m_writable_buffers({&res}),
+                m_adopted_buffers(),
+                m_free_buffers(),
+                m_subexpressions(),
+                m_common_count(0),
+                m_shared_uses()
             {
                 this->mark_as_free(&res);
             }
 
+            // The buffers of a pool built from a shape only are temporaries:
+            // the result can be an operand of the expression
+            explicit zarray_temporary_pool(const shape_type& shape)
+            :   m_shape(shape),
+                p_result(nullptr),
+                m_buffers(),
+                m_writable_buffers(),
+                m_adopted_buffers(),
+                m_free_buffers(),
+                m_subexpressions(),
+                m_common_count(0),
+                m_shared_uses()
+            {
+            }
+
             auto get_free_buffer(const std::size_t type_index)
             {
                 auto r = m_free_buffers.find(type_index);
                 if(r == m_free_buffers.end() || r->second.empty())
                 {
                     // make new buffer
+                    ZARRAY_TRACE_SCOPE(trace, "temporary", zarray_impl_register::data_type(type_index));
                     auto buffer_ptr = zarray_impl_register::get(type_index).clone();
                     buffer_ptr->resize(m_shape);
                     m_buffers.emplace_back(buffer_ptr);
+                    m_writable_buffers.insert(buffer_ptr);
+                    ZARRAY_TRACE_ARGS(trace, temporary_trace_args(type_index));
                     return buffer_ptr;
                 }
                 else
@@ -57,11 +87,121 @@ namespace xt
                 }
             };
 
+            // Returns the result buffer if it is free and has the given type
+            zarray_impl * get_free_result_buffer(const std::size_t type_index)
+            {
+                if(p_result != nullptr && p_result->get_class_index() == type_index)
+                {
+                    auto r = m_free_buffers.find(type_index);
+                    if(r != m_free_buffers.end() && r->second.erase(p_result) != 0)
+                    {
+                        return p_result;
+                    }
+                }
+                return nullptr;
+            }
+
+            bool is_result(const zarray_impl * buffer_ptr) const
+            {
+                return buffer_ptr == p_result;
+            }
+
             void mark_as_free(const zarray_impl * buffer_ptr)
             {
-                m_free_buffers[buffer_ptr->get_class_index()].insert(
-                    const_cast<zarray_impl *>(buffer_ptr)
-                );
+                zarray_impl * writable_ptr = get_writable(buffer_ptr);
+                if(writable_ptr != nullptr)
+                {
+                    m_free_buffers[buffer_ptr->get_class_index()].insert(writable_ptr);
+                }
+            }
+
+            // Registers the buffer of a temporary zarray operand of a
+            // consumed expression: it can be overwritten by the result
+            // or an intermediate result
+            void adopt(zarray_impl & buffer)
+            {
+                m_writable_buffers.insert(&buffer);
+                m_adopted_buffers.insert(&buffer);
+            }
+
+            bool is_adopted(const zarray_impl * buffer_ptr) const
+            {
+                return m_adopted_buffers.find(buffer_ptr) != m_adopted_buffers.end();
+            }
+
+            // Returns the buffer if the pool can overwrite it: the result,
+            // a temporary of the pool or an adopted operand, nullptr otherwise
+            zarray_impl * get_writable(const zarray_impl * buffer_ptr) const
+            {
+                auto r = m_writable_buffers.find(buffer_ptr);
+                return r != m_writable_buffers.end() ? *r : nullptr;
+            }
+
+            // Common subexpressions are identified by a key describing their
+            // operations and operands. They are counted before the evaluation,
+            // those occurring several times are evaluated once and their
+            // buffer is shared by their consumers. Returns the number of
+            // occurrences of the subexpression counted so far.
+            std::size_t count_subexpression(const key_type & key)
+            {
+                std::size_t count = ++(m_subexpressions[key].count);
+                if(count == 2)
+                {
+                    ++m_common_count;
+                }
+                return count;
+            }
+
+            bool has_common_subexpressions() const
+            {
+                return m_common_count != 0;
+            }
+
+            std::size_t common_subexpression_count() const
+            {
+                return m_common_count;
+            }
+
+            bool is_common_subexpression(const key_type & key) const
+            {
+                auto r = m_subexpressions.find(key);
+                return r != m_subexpressions.end() && r->second.count > 1;
+            }
+
+            // Returns nullptr if the subexpression has not been evaluated yet
+            zarray_impl * get_common_result(const key_type & key) const
+            {
+                return m_subexpressions.find(key)->second.buffer;
+            }
+
+            void set_common_result(const key_type & key, zarray_impl * buffer_ptr)
+            {
+                auto& s = m_subexpressions[key];
+                s.buffer = buffer_ptr;
+                m_shared_uses[buffer_ptr] = s.count;
+            }
+
+            // Called by each consumer of a buffer, returns false while the
+            // buffer holds a common subexpression with pending consumers:
+            // it can then neither be reused nor marked as free
+            bool consume(const zarray_impl * buffer_ptr)
+            {
+                auto r = m_shared_uses.find(buffer_ptr);
+                if(r == m_shared_uses.end())
+                {
+                    return true;
+                }
+                if(--(r->second) == 0)
+                {
+                    m_shared_uses.erase(r);
+                    return true;
+                }
+                return false;
+            }
+
+            const shape_type & shape() const
+            {
+                return m_shape;
             }
 
             std::size_t size() const
@@ -71,13 +211,41 @@ namespace xt
 
         private:
 
+            nlohmann::json temporary_trace_args(const std::size_t type_index) const
+            {
+                std::size_t size = std::accumulate(m_shape.cbegin(), m_shape.cend(), std::size_t(1), std::multiplies<std::size_t>());
+                nlohmann::json trace_args;
+                trace_args["shape"] = ztrace_shape(m_shape);
+                trace_args["bytes"] = size * zarray_impl_register::value_size(type_index);
+                return trace_args;
+            }
+
             const shape_type & m_shape;
 
+            // the buffer receiving the result, if any
+            zarray_impl * p_result;
+
             // a vector of buffers since an arbitrary number of temps can be needed
             std::vector<std::unique_ptr<zarray_impl>>  m_buffers;
 
+            // the buffers the pool can overwrite, and the adopted operands
+            std::set<zarray_impl *, std::less<>> m_writable_buffers;
+            std::set<const zarray_impl *, std::less<>> m_adopted_buffers;
+
             // free buffers of different types
             std::map<std::size_t, std::set<zarray_impl * > >  m_free_buffers;
+
+            struct subexpression
+            {
+                std::size_t count = 0;
+                zarray_impl * buffer = nullptr;
+            };
+
+            std::map<key_type, subexpression> m_subexpressions;
+            std::size_t m_common_count;
+
+            // pending consumers of the buffers of common subexpressions
+            std::map<const zarray_impl *, std::size_t> m_shared_uses;
         };
     }
 }
@@ -36,6 +36,7 @@ namespace xt
 
         bool is_array() const override;
         bool is_chunked() const override;
+        bool owns_buffer() const override;
 
         xarray<value_type>& get_array() override;
         const xarray<value_type>& get_array() const override;
@@ -61,7 +62,7 @@ namespace xt
         zarray_wrapper(const zarray_wrapper&) = default;
 
         CTE m_array;
-        nlohmann::json m_metadata;
+        zmetadata<value_type> m_metadata;
     };
 
     /*********************************
@@ -115,7 +116,6 @@ namespace xt
         : base_type()
         , m_array(std::forward<E>(e))
     {
-        detail::set_data_type<value_type>(m_metadata);
     }
 
     template <class CTE>
@@ -130,9 +130,16 @@ namespace xt
         return false;
     }
 
+    template <class CTE>
+    bool zarray_wrapper<CTE>::owns_buffer() const
+    {
+        return !std::is_reference<CTE>::value && !std::is_const<CTE>::value;
+    }
+
     template <class CTE>
     auto zarray_wrapper<CTE>::get_array() -> xarray<value_type>&
     {
+        this->update_version();
         return detail::zarray_wrapper_helper<value_type>::get_array(m_array);
     }
 
@@ -163,6 +170,7 @@ namespace xt
     template <class CTE>
     zarray_impl* zarray_wrapper<CTE>::strided_view(slice_vector& slices)
     {
+        this->update_version();
         auto e = xt::strided_view(m_array, slices);
         return detail::build_zarray(std::move(e));
     }
@@ -170,13 +178,13 @@ namespace xt
     template <class CTE>
     auto zarray_wrapper<CTE>::get_metadata() const -> const nlohmann::json&
     {
-        return m_metadata;
+        return m_metadata.get();
     }
 
     template <class CTE>
     void zarray_wrapper<CTE>::set_metadata(const nlohmann::json& metadata)
     {
-        m_metadata = metadata;
+        m_metadata.set(metadata);
     }
 
     template <class CTE>
@@ -194,24 +202,28 @@ namespace xt
     template <class CTE>
     void zarray_wrapper<CTE>::reshape(const shape_type& shape)
     {
+        this->update_version();
         detail::zarray_wrapper_helper<value_type>::reshape(m_array, shape);
     }
 
     template <class CTE>
     void zarray_wrapper<CTE>::reshape(shape_type&& shape)
     {
+        this->update_version();
         detail::zarray_wrapper_helper<value_type>::reshape(m_array, std::move(shape));
     }
 
     template <class CTE>
     void zarray_wrapper<CTE>::resize(const shape_type& shape)
     {
+        this->update_version();
         detail::zarray_wrapper_helper<value_type>::resize(m_array, shape);
     }
 
     template <class CTE>
     void zarray_wrapper<CTE>::resize(shape_type&& shape)
     {
+        this->update_version();
         detail::zarray_wrapper_helper<value_type>::resize(m_array, std::move(shape));
     }
 
@@ -16,7 +16,9 @@
 #include <xtl/xmultimethods.hpp>
 #include <xtensor/xarray.hpp>
 
+#include "zarray_impl_register.hpp"
 #include "zassign.hpp"
+#include "zfunction.hpp"
 #include "zfunctors.hpp"
 #include "zwrappers.hpp"
 
@@ -80,6 +82,46 @@ namespace xt
         template <class E>
         zarray& operator=(const xexpression<E>&);
 
+        template <class E>
+        zarray& operator+=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator+=(const E& e);
+
+        template <class E>
+        zarray& operator-=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator-=(const E& e);
+
+        template <class E>
+        zarray& operator*=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator*=(const E& e);
+
+        template <class E>
+        zarray& operator/=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator/=(const E& e);
+
+        template <class E>
+        zarray& operator%=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator%=(const E& e);
+
+        template <class E>
+        zarray& operator&=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator&=(const E& e);
+
+        template <class E>
+        zarray& operator|=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator|=(const E& e);
+
+        template <class E>
+        zarray& operator^=(const xexpression<E>& e);
+        template <class E>
+        disable_xexpression<E, zarray&> operator^=(const E& e);
+
         void swap(zarray& rhs);
 
         bool has_implementation() const;
@@ -98,6 +140,9 @@ namespace xt
 
         void assign_to(zarray_impl& dst, const zassign_args& args) const;
 
+        bool is_lazy() const;
+        zarray& evaluate();
+
         std::size_t dimension() const;
         const shape_type& shape() const;
         void reshape(const shape_type& shape);
@@ -106,6 +151,7 @@ namespace xt
         void resize(shape_type&& shape);
         bool broadcast_shape(shape_type& shape, bool reuse_cache = false) const;
 
+        zchunked_array& as_chunked_array();
         const zchunked_array& as_chunked_array() const;
 
         const nlohmann::json& get_metadata() const;
@@ -119,18 +165,214 @@ namespace xt
         template <class E>
         void init_implementation(const xexpression<E>& e, zarray_expression_tag);
 
+        template <class E>
+        void init_implementation(xexpression<E>&& e, zarray_expression_tag);
+
         template <class E>
         zarray& assign_expression(const xexpression<E>& e, xtensor_expression_tag);
 
         template <class E>
         zarray& assign_expression(const xexpression<E>& e, zarray_expression_tag);
 
+        template <class F, class E>
+        bool compound_assign(const E& e, zarray_expression_tag);
+
+        template <class F, class E, class Tag>
+        bool compound_assign(const E& e, Tag);
+
         implementation_ptr p_impl;
     };
 
     zarray strided_view(zarray& z, xstrided_slice_vector& slices);
     std::ostream& operator<<(std::ostream& out, const zarray& ar);
 
+    namespace zt
+    {
+        template <class E, class S>
+        zarray eval_chunked(const xexpression<E>& e, const S& chunk_shape);
+
+        template <class E>
+        zarray lazy(const xexpression<E>& e);
+    }
+
+    namespace detail
+    {
+        template <>
+        struct zchunk_input_key_builder<zarray>
+        {
+            static bool run(const zarray& e, const zarray_impl& res, std::size_t index, std::vector<std::size_t>& key)
+            {
+                return append_chunk_version(e.get_implementation(), res, index, key);
+            }
+        };
+
+        template <>
+        struct zsubexpression_key_builder<zarray>
+        {
+            static bool run(const zarray& e, std::vector<std::size_t>& key)
+            {
+                const zarray_impl& impl = e.get_implementation();
+                key.push_back(reinterpret_cast<std::size_t>(&impl));
+                key.push_back(impl.version());
+                return true;
+            }
+        };
+
+        // Copies and moves between dense arrays of the same value
+        // type do not need the dispatching nor the broadcasting
+        inline bool has_same_dense_type(const zarray_impl& lhs, const zarray_impl& rhs)
+        {
+            return lhs.is_array() && rhs.is_array() && lhs.get_class_index() == rhs.get_class_index();
+        }
+
+        template <>
+        struct zinplace_operand_checker<zarray>
+        {
+            static bool run(const zarray& e, const zarray_impl& res)
+            {
+                const zarray_impl& impl = e.get_implementation();
+                return &impl == &res || impl.is_array() || impl.is_chunked();
+            }
+        };
+
+        template <>
+        struct zchunked_operand_finder<zarray>
+        {
+            static const zchunked_array* run(const zarray& e, const dynamic_shape<std::size_t>& shape)
+            {
+                const zarray_impl& impl = e.get_implementation();
+                return impl.is_chunked() && impl.shape() == shape ? &(e.as_chunked_array()) : nullptr;
+            }
+        };
+
+        template <>
+        struct zlazy_operand_checker<zarray>
+        {
+            static bool run(const zarray& e)
+            {
+                return e.is_lazy();
+            }
+        };
+
+        // The subexpressions of a lazy operand are
+        // counted on its first occurrence only
+        template <>
+        struct zsubexpression_counter<zarray>
+        {
+            static void run(const zarray& e, zarray_temporary_pool& temporary_pool)
+            {
+                const zarray_impl& impl = e.get_implementation();
+                const zlazy_expression* lazy = impl.get_lazy_expression();
+                if (lazy != nullptr && is_inlined_lazy_operand(impl, temporary_pool) &&
+                    temporary_pool.count_subexpression(get_lazy_operand_key(impl)) == 1)
+                {
+                    lazy->count_subexpressions(temporary_pool);
+                }
+            }
+        };
+
+        /*************************
+         * zlazy_expression_impl *
+         *************************/
+
+        template <class E>
+        class zlazy_expression_impl : public zlazy_expression
+        {
+        public:
+
+            using self_type = zlazy_expression_impl<E>;
+
+            template <class OE>
+            explicit zlazy_expression_impl(OE&& e);
+
+            self_type* clone() const override;
+
+            std::size_t dimension() const override;
+            const shape_type& shape() const override;
+            bool broadcast_shape(shape_type& shape, bool reuse_cache = false) const override;
+
+            void assign_to(zarray_impl& res) const override;
+            std::tuple<const zarray_impl*, bool> assign_to(zarray_impl& res,
+                                                           zarray_temporary_pool& temporary_pool,
+                                                           const zassign_args& args) const override;
+            void count_subexpressions(zarray_temporary_pool& temporary_pool) const override;
+
+        private:
+
+            zlazy_expression_impl(const zlazy_expression_impl&) = default;
+
+            E m_e;
+        };
+
+        template <class E>
+        template <class OE>
+        inline zlazy_expression_impl<E>::zlazy_expression_impl(OE&& e)
+            : zlazy_expression()
+            , m_e(std::forward<OE>(e))
+        {
+        }
+
+        template <class E>
+        inline auto zlazy_expression_impl<E>::clone() const -> self_type*
+        {
+            return new self_type(*this);
+        }
+
+        template <class E>
+        inline std::size_t zlazy_expression_impl<E>::dimension() const
+        {
+            return m_e.dimension();
+        }
+
+        template <class E>
+        inline auto zlazy_expression_impl<E>::shape() const -> const shape_type&
+        {
+            return m_e.shape();
+        }
+
+        template <class E>
+        inline bool zlazy_expression_impl<E>::broadcast_shape(shape_type& shape, bool reuse_cache) const
+        {
+            return m_e.broadcast_shape(shape, reuse_cache);
+        }
+
+        template <class E>
+        inline void zlazy_expression_impl<E>::assign_to(zarray_impl& res) const
+        {
+            auto shape = uninitialized_shape<shape_type>(m_e.dimension());
+            zassign_args args;
+            args.trivial_broadcast = m_e.broadcast_shape(shape, true);
+            res.resize(std::move(shape));
+            m_e.assign_to(res, args);
+        }
+
+        // The broadcasting of the operands is computed against the shape
+        // of the expression. The result computed in the pool is copied to
+        // res and remains an input of the enclosing expression, which can
+        // overwrite it.
+        template <class E>
+        inline std::tuple<const zarray_impl*, bool>
+        zlazy_expression_impl<E>::assign_to(zarray_impl& res, zarray_temporary_pool& temporary_pool,
+                                            const zassign_args& args) const
+        {
+            auto shape = uninitialized_shape<shape_type>(m_e.dimension());
+            zassign_args lazy_args(args);
+            lazy_args.trivial_broadcast = m_e.broadcast_shape(shape, true);
+            auto input = detail::get_array_impl(m_e, temporary_pool, lazy_args);
+            res.resize(std::move(shape));
+            zassign_args copy_args;
+            copy_args.trivial_broadcast = true;
+            zdispatcher_t<detail::xassign_dummy_functor, 1>::dispatch(*std::get<0>(input), res, copy_args);
+            return input;
+        }
+
+        template <class E>
+        inline void zlazy_expression_impl<E>::count_subexpressions(zarray_temporary_pool& temporary_pool) const
+        {
+            zsubexpression_counter<E>::run(m_e, temporary_pool);
+        }
+    }
+
     /*************************
      * zarray implementation *
      *************************/
@@ -148,6 +390,27 @@ namespace xt
         semantic_base::assign(e);
     }
 
+    // The expression is a temporary: the buffers of its
+    // temporary zarray operands can be reused
+    template <class E>
+    inline void zarray::init_implementation(xexpression<E>&& e, zarray_expression_tag)
+    {
+        E& rhs = e.derived_cast();
+        p_impl = rhs.allocate_result();
+        if (p_impl->is_chunked())
+        {
+            semantic_base::assign(rhs);
+        }
+        else
+        {
+            auto shape = uninitialized_shape<shape_type>(rhs.dimension());
+            zassign_args args;
+            args.trivial_broadcast = rhs.broadcast_shape(shape, true);
+            resize(std::move(shape));
+            detail::consume_to(rhs, *p_impl, args);
+        }
+    }
+
     template <class E>
     inline zarray& zarray::assign_expression(const xexpression<E>& e, xtensor_expression_tag)
     {
@@ -205,7 +468,12 @@ namespace xt
 
     inline zarray& zarray::operator=(const zarray& rhs)
     {
-        if(this->has_implementation())
+        if(this->has_implementation() && detail::has_same_dense_type(*p_impl, *(rhs.p_impl)))
+        {
+            p_impl->copy_array(*(rhs.p_impl));
+            p_impl->update_version();
+        }
+        else if(this->has_implementation())
         {
             resize(rhs.shape());
             zassign_args args;
@@ -237,8 +505,15 @@ namespace xt
 
     inline zarray& zarray::operator=(zarray&& rhs)
     {
-        if(this->has_implementation())
+        if(this->has_implementation() && detail::has_same_dense_type(*p_impl, *(rhs.p_impl)))
+        {
+            p_impl->move_array(*(rhs.p_impl));
+            p_impl->update_version();
+            rhs.p_impl->update_version();
+        }
+        else if(this->has_implementation())
         {
+            p_impl->update_version();
             zassign_args args;
             args.trivial_broadcast = true;
             if (p_impl->is_chunked())
@@ -285,6 +560,77 @@ namespace xt
         return assign_expression(e, extension::get_expression_tag_t<std::decay_t<E>>());
     }
 
+    // Compound assignments evaluate the expression in the buffer of the
+    // zarray when the result has its type and shape, without temporary.
+    // Otherwise they assign the result of the binary operation.
+    template <class F, class E>
+    inline bool zarray::compound_assign(const E& e, zarray_expression_tag)
+    {
+        using dispatcher_type = zdispatcher_t<F, 2>;
+        using argument_type = detail::zargument_type_t<E>;
+
+        const argument_type& rhs = e;
+        if (!has_implementation() || !p_impl->is_array() ||
+            rhs.dimension() > p_impl->dimension() ||
+            !detail::zinplace_operand_checker<argument_type>::run(rhs, *p_impl))
+        {
+            return false;
+        }
+
+        const zarray_impl& rhs_prototype = zarray_impl_register::get(detail::get_result_type_index(rhs));
+        if (dispatcher_type::get_type_index(*p_impl, rhs_prototype) != p_impl->get_class_index())
+        {
+            return false;
+        }
+
+        shape_type shape = p_impl->shape();
+        zassign_args args;
+        args.trivial_broadcast = rhs.broadcast_shape(shape);
+        if (shape != p_impl->shape())
+        {
+            return false;
+        }
+
+        detail::zarray_temporary_pool temporary_pool(shape);
+        detail::count_subexpressions(rhs, temporary_pool);
+        auto input = detail::get_array_impl(rhs, temporary_pool, args);
+        dispatcher_type::dispatch(*p_impl, *std::get<0>(input), *p_impl, args);
+        p_impl->update_version();
+        return true;
+    }
+
+    template <class F, class E, class Tag>
+    inline bool zarray::compound_assign(const E&, Tag)
+    {
+        return false;
+    }
+
+#define XTENSOR_ZARRAY_COMPOUND_ASSIGN(OP, XFUN)                                                   \
+    template <class E>                                                                             \
+    inline zarray& zarray::operator OP(const xexpression<E>& e)                                    \
+    {                                                                                              \
+        using tag = extension::get_expression_tag_t<std::decay_t<E>>;                              \
+        return compound_assign<XFUN>(e.derived_cast(), tag()) ? *this : semantic_base::operator OP(e); \
+    }                                                                                              \
+                                                                                                   \
+    template <class E>                                                                             \
+    inline disable_xexpression<E, zarray&> zarray::operator OP(const E& e)                         \
+    {                                                                                              \
+        using scalar_type = zscalar_wrapper<xscalar<E>>;                                           \
+        return compound_assign<XFUN>(scalar_type(e), zarray_expression_tag()) ? *this : semantic_base::operator OP(e); \
+    }
+
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(+=, detail::plus)
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(-=, detail::minus)
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(*=, detail::multiplies)
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(/=, detail::divides)
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(%=, detail::modulus)
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(&=, detail::bitwise_and)
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(|=, detail::bitwise_or)
+    XTENSOR_ZARRAY_COMPOUND_ASSIGN(^=, detail::bitwise_xor)
+
+#undef XTENSOR_ZARRAY_COMPOUND_ASSIGN
+
     inline void zarray::swap(zarray& rhs)
     {
         std::swap(p_impl, rhs.p_impl);
@@ -295,8 +641,10 @@ namespace xt
         return bool(p_impl);
     }
 
+    // The implementation may be modified, its version is updated
     inline zarray_impl& zarray::get_implementation()
     {
+        p_impl->update_version();
         return *p_impl;
     }
 
@@ -315,6 +663,7 @@ namespace xt
     template <class T>
     inline xarray<T>& zarray::get_array()
     {
+        p_impl->update_version();
         return dynamic_cast<ztyped_array<T>*>(p_impl.get())->get_array();
     }
 
@@ -330,6 +679,26 @@ namespace xt
         zdispatcher_t<detail::xassign_dummy_functor, 1>::dispatch(get_implementation(), dst, args);
     }
 
+    inline bool zarray::is_lazy() const
+    {
+        return has_implementation() && p_impl->get_lazy_expression() != nullptr;
+    }
+
+    // Evaluates the expression of a lazy zarray in a dense array, which
+    // keeps its metadata. Lazy operands of the expression are evaluated
+    // with it, sharing its temporaries and common subexpressions.
+    inline zarray& zarray::evaluate()
+    {
+        if (is_lazy())
+        {
+            implementation_ptr res(zarray_impl_register::get(p_impl->get_class_index()).clone());
+            p_impl->get_lazy_expression()->assign_to(*res);
+            res->set_metadata(p_impl->get_metadata());
+            p_impl = std::move(res);
+        }
+        return *this;
+    }
+
     inline std::size_t zarray::dimension() const
     {
         return p_impl->dimension();
@@ -342,21 +711,25 @@ namespace xt
 
     inline void zarray::reshape(const shape_type& shape)
     {
+        p_impl->update_version();
         p_impl->reshape(shape);
     }
 
     inline void zarray::reshape(shape_type&& shape)
     {
+        p_impl->update_version();
         p_impl->reshape(std::move(shape));
     }
 
     inline void zarray::resize(const shape_type& shape)
     {
+        p_impl->update_version();
         p_impl->resize(shape);
     }
 
     inline void zarray::resize(shape_type&& shape)
     {
+        p_impl->update_version();
         p_impl->resize(std::move(shape));
     }
 
@@ -365,6 +738,12 @@ namespace xt
         return p_impl->broadcast_shape(shape, reuse_cache);
     }
 
+    inline zchunked_array& zarray::as_chunked_array()
+    {
+        p_impl->update_version();
+        return dynamic_cast<zchunked_array&>(*(p_impl.get()));
+    }
+
     inline const zchunked_array& zarray::as_chunked_array() const
     {
         return dynamic_cast<const zchunked_array&>(*(p_impl.get()));
@@ -390,6 +769,35 @@ namespace xt
     {
         return ar.get_implementation().print(out);
     }
+
+    namespace zt
+    {
+        // Evaluates an expression chunk by chunk into an in-memory
+        // chunked array with the given chunk shape
+        template <class E, class S>
+        inline zarray eval_chunked(const xexpression<E>& e, const S& chunk_shape)
+        {
+            const E& de = e.derived_cast();
+            zarray::shape_type cs(chunk_shape.cbegin(), chunk_shape.cend());
+            std::size_t idx = detail::get_result_type_index(de);
+            zarray res(zarray::implementation_ptr(zarray_impl_register::make_chunked(idx, de.shape(), cs)));
+            noalias(res) = de;
+            return res;
+        }
+
+        // Builds a lazy zarray holding the expression e unevaluated: it is
+        // evaluated once, by zarray::evaluate, on the first access to its
+        // data, or with an expression it is an operand of. The zarray
+        // operands held by reference in e must outlive its evaluation.
+        template <class E>
+        inline zarray lazy(const xexpression<E>& e)
+        {
+            const E& de = e.derived_cast();
+            std::size_t idx = detail::get_result_type_index(de);
+            zlazy_expression* expr = new detail::zlazy_expression_impl<E>(de);
+            return zarray(zarray::implementation_ptr(zarray_impl_register::make_lazy(idx, expr)));
+        }
+    }
 }
 
 #endif
@@ -11,6 +11,7 @@
 #define XTENSOR_ZASSIGN_HPP
 
 #include "xtensor/xassign.hpp"
+#include "ztracer.hpp"
 #include "zwrappers.hpp"
 
 namespace xt
@@ -37,16 +38,107 @@ namespace xt
 
     namespace detail
     {
+        // Computes the key of the inputs of the chunk index of res, that
+        // is the versions of the chunks of the leaves the result chunk
+        // depends on, and a description of the operations applied to them.
+        // Returns false when the chunk cannot be tracked. Specialized for
+        // zarray and zfunction.
+        template <class E>
+        struct zchunk_input_key_builder
+        {
+            static bool run(const E&, const zarray_impl&, std::size_t, std::vector<std::size_t>&)
+            {
+                return false;
+            }
+        };
+
+        // Returns the first chunked leaf of the expression e whose shape
+        // is the given shape, or nullptr. Its chunk shape is used for
+        // chunked results. Specialized for zarray and zfunction.
+        template <class E>
+        struct zchunked_operand_finder
+        {
+            static const zchunked_array* run(const E&, const dynamic_shape<std::size_t>&)
+            {
+                return nullptr;
+            }
+        };
+
+        // Returns false when evaluating e in the buffer of res may
+        // read elements of res already overwritten, that is when a leaf
+        // of e is a view that may refer to the data of res. Specialized
+        // for zarray and zfunction.
+        template <class E>
+        struct zinplace_operand_checker
+        {
+            static bool run(const E&, const zarray_impl&)
+            {
+                return true;
+            }
+        };
+
+        // True when the chunk index of e covers the same region
+        // as the chunk index of the chunked array res
+        inline bool has_same_chunk_grid(const zarray_impl& e, const zarray_impl& res)
+        {
+            if (!e.is_chunked())
+            {
+                return false;
+            }
+            const zchunked_array& arr = dynamic_cast<const zchunked_array&>(e);
+            const zchunked_array& res_arr = dynamic_cast<const zchunked_array&>(res);
+            return arr.has_aligned_chunks() && res_arr.has_aligned_chunks()
+                && e.shape() == res.shape() && arr.chunk_shape() == res_arr.chunk_shape();
+        }
+
+        // Leaf inputs can be tracked only when they have
+        // the same chunk grid as the result
+        inline bool append_chunk_version(const zarray_impl& e,
+                                         const zarray_impl& res,
+                                         std::size_t index,
+                                         std::vector<std::size_t>& key)
+        {
+            bool same_grid = has_same_chunk_grid(e, res);
+            if (same_grid)
+            {
+                key.push_back(dynamic_cast<const zchunked_array&>(e).chunk_version(index));
+            }
+            return same_grid;
+        }
+
+        inline nlohmann::json zchunk_trace_args(const zchunked_iterator& chunk_iter)
+        {
+            nlohmann::json trace_args;
+            trace_args["index"] = chunk_iter.chunk_index();
+            trace_args["coords"] = ztrace_shape(chunk_iter.chunk_coords());
+            trace_args["shape"] = ztrace_shape(chunk_iter.chunk_extent());
+            return trace_args;
+        }
+
         template <class E1, class E2, class F>
         void run_chunked_assign_loop(E1 & e1, const E2& e2, zassign_args& args, F f)
         {
-            const zchunked_array& arr = e1.as_chunked_array();
+            zchunked_array& arr = e1.as_chunked_array();
             args.chunk_iter = arr.chunk_begin();
             args.chunk_assign = true;
             auto chunk_end = arr.chunk_end();
+            bool incremental = arr.is_incremental();
+            std::vector<std::size_t> key;
             while (args.chunk_iter != chunk_end)
             {
-                f(e1, e2, args);
+                std::size_t index = args.chunk_iter.chunk_index();
+                key.clear();
+                bool tracked = incremental && zchunk_input_key_builder<E2>::run(e2, e1.get_implementation(), index, key);
+                if (!tracked || !arr.is_chunk_up_to_date(index, key))
+                {
+                    ZARRAY_TRACE_SCOPE(trace, "chunk", std::string("chunk"));
+                    ZARRAY_TRACE_ARGS(trace, zchunk_trace_args(args.chunk_iter));
+                    f(e1, e2, args);
+                    if (tracked)
+                    {
+                        arr.set_chunk_input_key(index, std::move(key));
+                    }
+                }
                 ++args.chunk_iter;
             }
         }
@@ -158,6 +250,593 @@ namespace xt
             expr_lhs.assign(std::move(tmp));
         }
     }
+
+    /*********************
+     * zassign_broadcast *
+     *********************/
+
+    namespace detail
+    {
+        // Position of the elements of an operand in the loops of a
+        // broadcast kernel: the outer loop runs over the dimensions of
+        // the result before the split, the inner loop over the contiguous
+        // dimensions after the split. A stride of 0 repeats the elements.
+        struct zbroadcast_operand
+        {
+            std::size_t outer_stride;
+            std::size_t inner_stride;
+        };
+
+        // An operand can be full, repeated along the outer dimensions
+        // (a row vector against a matrix), repeated along the inner
+        // dimensions (a column vector) or a single value
+        template <class S, class RS>
+        inline bool get_broadcast_operand(const S& shape,
+                                          const RS& res_shape,
+                                          std::size_t split,
+                                          std::size_t inner_size,
+                                          zbroadcast_operand& operand)
+        {
+            std::size_t offset = res_shape.size() - shape.size();
+            bool outer_full = true, outer_repeated = true;
+            bool inner_full = true, inner_repeated = true;
+            for (std::size_t d = 0; d < res_shape.size(); ++d)
+            {
+                std::size_t dim = d < offset ? std::size_t(1) : shape[d - offset];
+                if (dim != res_shape[d] && dim != 1)
+                {
+                    return false;
+                }
+                if (res_shape[d] == 1)
+                {
+                    continue;
+                }
+                bool full = dim == res_shape[d];
+                bool& is_full = d < split ? outer_full : inner_full;
+                bool& is_repeated = d < split ? outer_repeated : inner_repeated;
+                is_full = is_full && full;
+                is_repeated = is_repeated && !full;
+            }
+
+            if (outer_full && inner_full)
+            {
+                operand = {inner_size, 1};
+            }
+            else if (outer_repeated && inner_full)
+            {
+                operand = {0, 1};
+            }
+            else if (outer_full && inner_repeated)
+            {
+                operand = {1, 0};
+            }
+            else if (outer_repeated && inner_repeated)
+            {
+                operand = {0, 0};
+            }
+            else
+            {
+                return false;
+            }
+            return true;
+        }
+
+        // The inner strides are template parameters so that
+        // the inner loop is vectorized
+        template <std::size_t S1, std::size_t S2, class F, class T1, class T2, class R>
+        inline void run_broadcast_kernel(F&& f,
+                                         const T1* p1, const zbroadcast_operand& op1,
+                                         const T2* p2, const zbroadcast_operand& op2,
+                                         R* res, std::size_t outer_size, std::size_t inner_size)
+        {
+            for (std::size_t o = 0; o < outer_size; ++o)
+            {
+                const T1* in1 = p1 + o * op1.outer_stride;
+                const T2* in2 = p2 + o * op2.outer_stride;
+                R* out = res + o * inner_size;
+                for (std::size_t i = 0; i < inner_size; ++i)
+                {
+                    out[i] = static_cast<R>(f(in1[i * S1], in2[i * S2]));
+                }
+            }
+        }
+
+        template <class T>
+        inline bool get_broadcast_data(const ztyped_array<T>& z, const T*& data, const dynamic_shape<std::size_t>*& shape)
+        {
+            static const dynamic_shape<std::size_t> scalar_shape = {};
+            data = z.scalar_value();
+            if (data != nullptr)
+            {
+                shape = &scalar_shape;
+                return true;
+            }
+            if (!z.is_array())
+            {
+                return false;
+            }
+            const xarray<T>& a = z.get_array();
+            data = a.data();
+            shape = &(a.shape());
+            return true;
+        }
+    }
+
+    // Binary operations whose operands are broadcast along the outer or
+    // the inner dimensions of the result (a matrix and a row vector, a
+    // column vector or a scalar) run a dedicated kernel instead of the
+    // stepper based assignment of non-trivial broadcasts
+    template <class F, class T1, class T2, class R>
+    inline bool zassign_broadcast(F&& f,
+                                  const ztyped_array<T1>& z1,
+                                  const ztyped_array<T2>& z2,
+                                  ztyped_array<R>& zres,
+                                  const zassign_args& args)
+    {
+        if (args.trivial_broadcast || args.chunk_assign || !zres.is_array() ||
+            xarray<T1>::static_layout != layout_type::row_major)
+        {
+            return false;
+        }
+
+        const T1* p1 = nullptr;
+        const T2* p2 = nullptr;
+        const dynamic_shape<std::size_t>* shape1 = nullptr;
+        const dynamic_shape<std::size_t>* shape2 = nullptr;
+        if (!detail::get_broadcast_data(z1, p1, shape1) || !detail::get_broadcast_data(z2, p2, shape2))
+        {
+            return false;
+        }
+
+        xarray<R>& res = zres.get_array();
+        const auto& res_shape = res.shape();
+        if (res.size() == 0 || shape1->size() > res_shape.size() || shape2->size() > res_shape.size())
+        {
+            return false;
+        }
+
+        std::size_t inner_size = static_cast<std::size_t>(res.size());
+        std::size_t outer_size = 1;
+        for (std::size_t split = 0; split <= res_shape.size(); ++split)
+        {
+            if (split != 0)
+            {
+                inner_size /= res_shape[split - 1];
+                outer_size *= res_shape[split - 1];
+            }
+            detail::zbroadcast_operand op1, op2;
+            if (detail::get_broadcast_operand(*shape1, res_shape, split, inner_size, op1) &&
+                detail::get_broadcast_operand(*shape2, res_shape, split, inner_size, op2))
+            {
+                std::size_t strides = 2 * op1.inner_stride + op2.inner_stride;
+                switch (strides)
+                {
+                    case 0:
+                        detail::run_broadcast_kernel<0, 0>(f, p1, op1, p2, op2, res.data(), outer_size, inner_size);
+                        break;
+                    case 1:
+                        detail::run_broadcast_kernel<0, 1>(f, p1, op1, p2, op2, res.data(), outer_size, inner_size);
+                        break;
+                    case 2:
+                        detail::run_broadcast_kernel<1, 0>(f, p1, op1, p2, op2, res.data(), outer_size, inner_size);
+                        break;
+                    default:
+                        detail::run_broadcast_kernel<1, 1>(f, p1, op1, p2, op2, res.data(), outer_size, inner_size);
+                        break;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**************************
+     * zassign_constant_chunk *
+     **************************/
+
+    namespace detail
+    {
+        // Value of a 0-D operand, read inline for scalars
+        template <class T>
+        inline T get_scalar_value(const ztyped_array<T>& z)
+        {
+            const T* value = z.scalar_value();
+            return value != nullptr ? *value : *(z.get_array().cbegin());
+        }
+
+        template <class R>
+        inline ztyped_chunked_array<R>* get_fill_tracking_array(ztyped_array<R>& zres)
+        {
+            if (zres.is_chunked())
+            {
+                auto& res = static_cast<ztyped_chunked_array<R>&>(zres);
+                return res.has_fill_value() ? &res : nullptr;
+            }
+            return nullptr;
+        }
+
+        // Returns true if z holds a single value over the chunk
+        // of res currently pointed to by args.chunk_iter
+        template <class T, class R>
+        inline bool get_constant_chunk_value(const ztyped_array<T>& z,
+                                             const ztyped_chunked_array<R>& res,
+                                             const zassign_args& args,
+                                             T& value)
+        {
+            if (z.dimension() == 0)
+            {
+                value = get_scalar_value(z);
+                return true;
+            }
+            if (z.is_chunked())
+            {
+                const auto& cz = static_cast<const ztyped_chunked_array<T>&>(z);
+                std::size_t index = args.chunk_iter.chunk_index();
+                if (cz.shape() == res.shape() && cz.chunk_shape() == res.chunk_shape() && cz.is_fill_chunk(index))
+                {
+                    value = cz.chunk_fill_value(index);
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    // When the destination tracks fill chunks and every operand is constant
+    // over the current chunk, the result of the chunk is computed once from
+    // the operand values and stored as a fill chunk.
+    template <class F, class T, class R>
+    inline bool zassign_constant_chunk(F&& f, const ztyped_array<T>& z, ztyped_array<R>& zres, const zassign_args& args)
+    {
+        ztyped_chunked_array<R>* res = detail::get_fill_tracking_array(zres);
+        T value = T();
+        if (res != nullptr && detail::get_constant_chunk_value(z, *res, args, value))
+        {
+            res->assign_fill_chunk(static_cast<R>(f(value)), args.chunk_iter);
+            return true;
+        }
+        return false;
+    }
+
+    template <class F, class T1, class T2, class R>
+    inline bool zassign_constant_chunk(F&& f,
+                                       const ztyped_array<T1>& z1,
+                                       const ztyped_array<T2>& z2,
+                                       ztyped_array<R>& zres,
+                                       const zassign_args& args)
+    {
+        ztyped_chunked_array<R>* res = detail::get_fill_tracking_array(zres);
+        T1 value1 = T1();
+        T2 value2 = T2();
+        if (res != nullptr &&
+            detail::get_constant_chunk_value(z1, *res, args, value1) &&
+            detail::get_constant_chunk_value(z2, *res, args, value2))
+        {
+            res->assign_fill_chunk(static_cast<R>(f(value1, value2)), args.chunk_iter);
+            return true;
+        }
+        return false;
+    }
+
+    template <class F, class T1, class T2, class T3, class R>
+    inline bool zassign_constant_chunk(F&& f,
+                                       const ztyped_array<T1>& z1,
+                                       const ztyped_array<T2>& z2,
+                                       const ztyped_array<T3>& z3,
+                                       ztyped_array<R>& zres,
+                                       const zassign_args& args)
+    {
+        ztyped_chunked_array<R>* res = detail::get_fill_tracking_array(zres);
+        T1 value1 = T1();
+        T2 value2 = T2();
+        T3 value3 = T3();
+        if (res != nullptr &&
+            detail::get_constant_chunk_value(z1, *res, args, value1) &&
+            detail::get_constant_chunk_value(z2, *res, args, value2) &&
+            detail::get_constant_chunk_value(z3, *res, args, value3))
+        {
+            res->assign_fill_chunk(static_cast<R>(f(value1, value2, value3)), args.chunk_iter);
+            return true;
+        }
+        return false;
+    }
+
+    /************************
+     * zassign_pruned_chunk *
+     ************************/
+
+    namespace detail
+    {
+        // Comparison functors whose result over a whole chunk can be
+        // deduced from the chunk statistics specialize this trait.
+        // null_result is the result of the comparison with a NaN.
+        template <class F>
+        struct zchunk_pruner
+        {
+            static constexpr bool value = false;
+        };
+
+        // Ordered comparisons against a scalar are monotonic in the chunk
+        // value: they are constant over the chunk if they agree on min and max.
+        struct zordered_chunk_pruner
+        {
+            static constexpr bool value = true;
+            static constexpr bool null_result = false;
+
+            template <class T, class U>
+            static bool is_constant(const zchunk_statistics<T>&, const U&, bool min_result, bool max_result)
+            {
+                return min_result == max_result;
+            }
+        };
+
+        // Equality comparisons are constant over the chunk if the chunk
+        // holds a single value or if the scalar is out of [min, max].
+        struct zequality_chunk_pruner
+        {
+            static constexpr bool value = true;
+
+            template <class T, class U>
+            static bool is_constant(const zchunk_statistics<T>& s, const U& x, bool, bool)
+            {
+                return s.min == s.max || x < s.min || s.max < x;
+            }
+        };
+
+        template <>
+        struct zchunk_pruner<less> : zordered_chunk_pruner
+        {
+        };
+
+        template <>
+        struct zchunk_pruner<less_equal> : zordered_chunk_pruner
+        {
+        };
+
+        template <>
+        struct zchunk_pruner<greater> : zordered_chunk_pruner
+        {
+        };
+
+        template <>
+        struct zchunk_pruner<greater_equal> : zordered_chunk_pruner
+        {
+        };
+
+        template <>
+        struct zchunk_pruner<equal_to> : zequality_chunk_pruner
+        {
+            static constexpr bool null_result = false;
+        };
+
+        template <>
+        struct zchunk_pruner<not_equal_to> : zequality_chunk_pruner
+        {
+            static constexpr bool null_result = true;
+        };
+
+        // Returns the statistics of z over the chunk of res currently
+        // pointed to by args.chunk_iter, if z maintains them
+        template <class T, class R>
+        inline const zchunk_statistics<T>* get_chunk_statistics(const ztyped_array<T>& z,
+                                                                const ztyped_chunked_array<R>& res,
+                                                                const zassign_args& args)
+        {
+            if (z.is_chunked())
+            {
+                const auto& cz = static_cast<const ztyped_chunked_array<T>&>(z);
+                if (cz.has_chunk_statistics() && cz.shape() == res.shape() && cz.chunk_shape() == res.chunk_shape())
+                {
+                    return &cz.chunk_statistics(args.chunk_iter.chunk_index());
+                }
+            }
+            return nullptr;
+        }
+
+        // G applies the comparison to a chunk value
+        template <class P, class T, class U, class G>
+        inline bool prune_chunk(const zchunk_statistics<T>& s, const U& x, G&& g, bool& result)
+        {
+            if (s.null_count == s.size)
+            {
+                result = P::null_result;
+                return true;
+            }
+            bool min_result = g(s.min);
+            if (P::is_constant(s, x, min_result, g(s.max)) &&
+                (s.null_count == 0 || min_result == P::null_result))
+            {
+                result = min_result;
+                return true;
+            }
+            return false;
+        }
+
+        template <class F, class T1, class T2, class R>
+        inline bool zassign_pruned_chunk_impl(F&&,
+                                              const ztyped_array<T1>&,
+                                              const ztyped_array<T2>&,
+                                              ztyped_array<R>&,
+                                              const zassign_args&,
+                                              std::false_type)
+        {
+            return false;
+        }
+
+        template <class F, class T1, class T2, class R>
+        inline bool zassign_pruned_chunk_impl(F&& f,
+                                              const ztyped_array<T1>& z1,
+                                              const ztyped_array<T2>& z2,
+                                              ztyped_array<R>& zres,
+                                              const zassign_args& args,
+                                              std::true_type)
+        {
+            using pruner_type = zchunk_pruner<std::decay_t<F>>;
+
+            if (!zres.is_chunked())
+            {
+                return false;
+            }
+            auto& res = static_cast<ztyped_chunked_array<R>&>(zres);
+            bool result = false;
+            bool pruned = false;
+            if (z2.dimension() == 0)
+            {
+                const zchunk_statistics<T1>* s = get_chunk_statistics(z1, res, args);
+                if (s != nullptr)
+                {
+                    T2 x = get_scalar_value(z2);
+                    pruned = prune_chunk<pruner_type>(*s, x, [&f, &x](const T1& v) { return static_cast<bool>(f(v, x)); }, result);
+                }
+            }
+            else if (z1.dimension() == 0)
+            {
+                const zchunk_statistics<T2>* s = get_chunk_statistics(z2, res, args);
+                if (s != nullptr)
+                {
+                    T1 x = get_scalar_value(z1);
+                    pruned = prune_chunk<pruner_type>(*s, x, [&f, &x](const T2& v) { return static_cast<bool>(f(x, v)); }, result);
+                }
+            }
+            if (pruned)
+            {
+                res.assign_fill_chunk(static_cast<R>(result), args.chunk_iter);
+            }
+            return pruned;
+        }
+    }
+
+    // Comparing a chunked array maintaining chunk statistics with a scalar
+    // does not read the chunks whose result is known from their min and max.
+    template <class F, class T1, class T2, class R>
+    inline bool zassign_pruned_chunk(F&& f,
+                                     const ztyped_array<T1>& z1,
+                                     const ztyped_array<T2>& z2,
+                                     ztyped_array<R>& zres,
+                                     const zassign_args& args)
+    {
+        using supported = std::integral_constant<bool, detail::zchunk_pruner<std::decay_t<F>>::value>;
+        return detail::zassign_pruned_chunk_impl(std::forward<F>(f), z1, z2, zres, args, supported());
+    }
+
+    /**************************
+     * zassign_selected_chunk *
+     **************************/
+
+    namespace detail
+    {
+        // Returns true if the condition z has a single truth value over
+        // the chunk of res currently pointed to by args.chunk_iter, because
+        // z is constant over the chunk or because its statistics prove it
+        template <class T, class R>
+        inline bool get_constant_condition(const ztyped_array<T>& z,
+                                           const ztyped_chunked_array<R>& res,
+                                           const zassign_args& args,
+                                           bool& condition)
+        {
+            T value = T();
+            if (get_constant_chunk_value(z, res, args, value))
+            {
+                condition = static_cast<bool>(value);
+                return true;
+            }
+            const zchunk_statistics<T>* s = get_chunk_statistics(z, res, args);
+            if (s == nullptr)
+            {
+                return false;
+            }
+            // null values (NaN) are true
+            if (s->null_count == s->size || T(0) < s->min || s->max < T(0))
+            {
+                condition = true;
+                return true;
+            }
+            if (s->null_count == 0 && s->min == T(0) && s->max == T(0))
+            {
+                condition = false;
+                return true;
+            }
+            return false;
+        }
+
+        template <class T, class R>
+        inline void assign_selected_chunk(const ztyped_array<T>& z,
+                                          ztyped_chunked_array<R>& res,
+                                          const zassign_args& args)
+        {
+            T value = T();
+            ztyped_array<R>& zres = res;
+            if (res.has_fill_value() && get_constant_chunk_value(z, res, args, value))
+            {
+                res.assign_fill_chunk(static_cast<R>(value), args.chunk_iter);
+            }
+            else if (z.dimension() == 0)
+            {
+                zassign_wrapped_expression(zres, broadcast(static_cast<R>(get_scalar_value(z)), args.chunk_iter.chunk_extent()), args);
+            }
+            else
+            {
+                zassign_wrapped_expression(zres, z.get_chunk(args.slices()), args);
+            }
+        }
+
+        template <class F, class T1, class T2, class T3, class R>
+        inline bool zassign_selected_chunk_impl(F&&,
+                                                const ztyped_array<T1>&,
+                                                const ztyped_array<T2>&,
+                                                const ztyped_array<T3>&,
+                                                ztyped_array<R>&,
+                                                const zassign_args&,
+                                                std::false_type)
+        {
+            return false;
+        }
+
+        template <class F, class T1, class T2, class T3, class R>
+        inline bool zassign_selected_chunk_impl(F&&,
+                                                const ztyped_array<T1>& z1,
+                                                const ztyped_array<T2>& z2,
+                                                const ztyped_array<T3>& z3,
+                                                ztyped_array<R>& zres,
+                                                const zassign_args& args,
+                                                std::true_type)
+        {
+            if (!zres.is_chunked())
+            {
+                return false;
+            }
+            auto& res = static_cast<ztyped_chunked_array<R>&>(zres);
+            bool condition = false;
+            if (!get_constant_condition(z1, res, args, condition))
+            {
+                return false;
+            }
+            if (condition)
+            {
+                assign_selected_chunk(z2, res, args);
+            }
+            else
+            {
+                assign_selected_chunk(z3, res, args);
+            }
+            return true;
+        }
+    }
+
+    // A selection whose condition has a single truth value over the
+    // current chunk only reads the selected branch. If this branch is
+    // constant over the chunk too, the result is stored as a fill chunk.
+    template <class F, class T1, class T2, class T3, class R>
+    inline bool zassign_selected_chunk(F&& f,
+                                       const ztyped_array<T1>& z1,
+                                       const ztyped_array<T2>& z2,
+                                       const ztyped_array<T3>& z3,
+                                       ztyped_array<R>& zres,
+                                       const zassign_args& args)
+    {
+        using supported = std::is_same<std::decay_t<F>, detail::conditional_ternary>;
+        return detail::zassign_selected_chunk_impl(std::forward<F>(f), z1, z2, z3, zres, args, supported());
+    }
 }
 
 #endif
@@ -0,0 +1,473 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XTENSOR_ZCHUNK_PIPELINE_HPP
+#define XTENSOR_ZCHUNK_PIPELINE_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "zarray_zarray.hpp"
+#include "zdispatcher.hpp"
+#include "zfunction.hpp"
+
+namespace xt
+{
+    /********************
+     * pipelined_assign *
+     ********************/
+
+    // Assigns an expression to a chunked array in three overlapping
+    // stages: a prefetch thread reads the chunks of the inputs, the
+    // calling thread computes the chunks of the result and a write-back
+    // thread stores them. At most lookahead chunks are buffered between
+    // two consecutive stages. As with noalias, the result must not be
+    // one of the inputs of the expression.
+    template <class E>
+    void pipelined_assign(zarray& res, const xexpression<E>& e, std::size_t lookahead = 2);
+
+    /****************************
+     * zchunk_pipeline functors *
+     ****************************/
+
+    namespace detail
+    {
+        struct xchunk_read_dummy_functor {};
+        struct xchunk_write_dummy_functor {};
+
+        template <>
+        struct unary_dispatching_types<xchunk_read_dummy_functor>
+        {
+            using type = zunary_ident_types;
+        };
+
+        template <>
+        struct unary_dispatching_types<xchunk_write_dummy_functor>
+        {
+            using type = zunary_all_ztypes_combinations_types;
+        };
+
+        // Inputs with the same chunk grid as the result are read
+        // with their own chunk iterator, other inputs are sliced.
+        struct zchunk_read_args
+        {
+            const zchunked_iterator* leaf_iter;
+            const xstrided_slice_vector* slices;
+        };
+    }
+
+    struct zchunk_read_functor
+    {
+        template <class T, class R>
+        static void run(const ztyped_array<T>& z, ztyped_array<R>& zres, const detail::zchunk_read_args& args)
+        {
+            if (args.leaf_iter != nullptr)
+            {
+                const auto& chunked = static_cast<const ztyped_chunked_array<T>&>(z);
+                zres.get_array() = chunked.read_chunk(*(args.leaf_iter));
+            }
+            else
+            {
+                zres.get_array() = z.get_chunk(*(args.slices));
+            }
+        }
+
+        template <class T>
+        static size_t index(const ztyped_array<T>&)
+        {
+            return ztyped_array<T>::get_class_static_index();
+        }
+    };
+
+    struct zchunk_write_functor
+    {
+        template <class T, class R>
+        static void run(const ztyped_array<T>& z, ztyped_array<R>& zres, const zchunked_iterator& chunk_it)
+        {
+            auto& chunked = static_cast<ztyped_chunked_array<R>&>(zres);
+            chunked.assign_chunk(xarray<R>(z.get_array()), chunk_it);
+        }
+
+        template <class T>
+        static size_t index(const ztyped_array<T>&)
+        {
+            return ztyped_array<T>::get_class_static_index();
+        }
+    };
+
+    template <>
+    struct get_zmapped_functor<detail::xchunk_read_dummy_functor>
+    {
+        using type = zchunk_read_functor;
+    };
+
+    template <>
+    struct get_zmapped_functor<detail::xchunk_write_dummy_functor>
+    {
+        using type = zchunk_write_functor;
+    };
+
+    using zchunk_read_dispatcher = zdouble_dispatcher<detail::xchunk_read_dummy_functor,
+                                                      mpl::vector<const detail::zchunk_read_args>>;
+
+    using zchunk_write_dispatcher = zdouble_dispatcher<detail::xchunk_write_dummy_functor,
+                                                       mpl::vector<const zchunked_iterator>>;
+
+    /******************
+     * zbounded_queue *
+     ******************/
+
+    namespace detail
+    {
+        template <class T>
+        class zbounded_queue
+        {
+        public:
+
+            explicit zbounded_queue(std::size_t capacity);
+
+            // Blocks while the queue is full, returns false
+            // if the queue has been closed
+            bool push(T&& value);
+            // Blocks while the queue is empty, returns false
+            // if the queue has been closed and is empty
+            bool pop(T& value);
+            void close();
+
+        private:
+
+            std::size_t m_capacity;
+            std::deque<T> m_values;
+            bool m_closed;
+            std::mutex m_mutex;
+            std::condition_variable m_not_empty;
+            std::condition_variable m_not_full;
+        };
+
+        template <class T>
+        inline zbounded_queue<T>::zbounded_queue(std::size_t capacity)
+            : m_capacity(capacity)
+            , m_values()
+            , m_closed(false)
+        {
+        }
+
+        template <class T>
+        inline bool zbounded_queue<T>::push(T&& value)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_full.wait(lock, [this]() { return m_closed || m_values.size() < m_capacity; });
+            if (m_closed)
+            {
+                return false;
+            }
+            m_values.push_back(std::move(value));
+            m_not_empty.notify_one();
+            return true;
+        }
+
+        template <class T>
+        inline bool zbounded_queue<T>::pop(T& value)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_not_empty.wait(lock, [this]() { return m_closed || !m_values.empty(); });
+            if (m_values.empty())
+            {
+                return false;
+            }
+            value = std::move(m_values.front());
+            m_values.pop_front();
+            m_not_full.notify_one();
+            return true;
+        }
+
+        template <class T>
+        inline void zbounded_queue<T>::close()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_not_empty.notify_all();
+            m_not_full.notify_all();
+        }
+    }
+
+    /************************
+     * zchunk_pipeline_node *
+     ************************/
+
+    namespace detail
+    {
+        // Collects the zarray leaves of an expression, and rebuilds the
+        // expression with the chunks of these leaves read by the prefetch
+        // stage. Expressions involving reducers are not supported.
+        template <class E>
+        struct zchunk_pipeline_node : std::false_type
+        {
+        };
+
+        template <>
+        struct zchunk_pipeline_node<zarray> : std::true_type
+        {
+            using type = zarray;
+
+            static void collect(const zarray& e, std::vector<const zarray_impl*>& leaves)
+            {
+                leaves.push_back(&(e.get_implementation()));
+            }
+
+            static type rebind(const zarray&, std::vector<zarray>& chunks, std::size_t& pos)
+            {
+                return std::move(chunks[pos++]);
+            }
+        };
+
+        template <class CTE>
+        struct zchunk_pipeline_node<zscalar_wrapper<CTE>> : std::true_type
+        {
+            using type = zscalar_wrapper<CTE>;
+
+            static void collect(const type&, std::vector<const zarray_impl*>&)
+            {
+            }
+
+            static type rebind(const type& e, std::vector<zarray>&, std::size_t&)
+            {
+                return type(std::decay_t<CTE>(*e.scalar_value()));
+            }
+        };
+
+        template <class F, class... CT>
+        struct zchunk_pipeline_node<zfunction<F, CT...>>
+            : xtl::conjunction<zchunk_pipeline_node<std::decay_t<CT>>...>
+        {
+            using expression_type = zfunction<F, CT...>;
+            using type = zfunction<F, typename zchunk_pipeline_node<std::decay_t<CT>>::type...>;
+
+            static void collect(const expression_type& e, std::vector<const zarray_impl*>& leaves)
+            {
+                collect_impl(e, leaves, std::make_index_sequence<sizeof...(CT)>());
+            }
+
+            static type rebind(const expression_type& e, std::vector<zarray>& chunks, std::size_t& pos)
+            {
+                return rebind_impl(e, chunks, pos, std::make_index_sequence<sizeof...(CT)>());
+            }
+
+        private:
+
+            // Braced initializer lists are evaluated from left to right,
+            // leaves are rebound in the order they have been collected.
+            template <std::size_t... I>
+            static void collect_impl(const expression_type& e,
+                                     std::vector<const zarray_impl*>& leaves,
+                                     std::index_sequence<I...>)
+            {
+                int dummy[] = {0, (zchunk_pipeline_node<std::decay_t<CT>>::collect(std::get<I>(e.arguments()), leaves), 0)...};
+                (void)dummy;
+            }
+
+            template <std::size_t... I>
+            static type rebind_impl(const expression_type& e,
+                                    std::vector<zarray>& chunks,
+                                    std::size_t& pos,
+                                    std::index_sequence<I...>)
+            {
+                return type{F(), zchunk_pipeline_node<std::decay_t<CT>>::rebind(std::get<I>(e.arguments()), chunks, pos)...};
+            }
+        };
+    }
+
+    /***********************************
+     * pipelined_assign implementation *
+     ***********************************/
+
+    namespace detail
+    {
+        template <class E>
+        inline void pipelined_assign_impl(zarray& res, const E& e, std::size_t, std::false_type)
+        {
+            noalias(res) = e;
+        }
+
+        template <class E>
+        inline void pipelined_assign_impl(zarray& res, const E& e, std::size_t lookahead, std::true_type)
+        {
+            using node_type = zchunk_pipeline_node<E>;
+
+            std::vector<const zarray_impl*> leaves;
+            node_type::collect(e, leaves);
+            const zarray_impl& res_impl = res.get_implementation();
+
+            // Broadcast inputs cannot be sliced with the chunk slices of the result
+            auto same_shape = [&res_impl](const zarray_impl* l) { return l->shape() == res_impl.shape(); };
+            if (!std::all_of(leaves.cbegin(), leaves.cend(), same_shape))
+            {
+                noalias(res) = e;
+                return;
+            }
+
+            // Aligned leaves are read chunk by chunk, their traversal
+            // order may differ from the one of the result
+            std::vector<const zchunk_grid*> leaf_grids(leaves.size(), nullptr);
+            for (std::size_t i = 0; i < leaves.size(); ++i)
+            {
+                if (has_same_chunk_grid(*leaves[i], res_impl))
+                {
+                    leaf_grids[i] = &(dynamic_cast<const zchunked_array&>(*leaves[i]).chunk_grid());
+                }
+            }
+
+            const zchunked_array& arr = res.as_chunked_array();
+            zchunked_iterator read_it = arr.chunk_begin();
+            zchunked_iterator write_it = arr.chunk_begin();
+            zchunked_iterator chunk_end = arr.chunk_end();
+
+            zbounded_queue<std::vector<zarray>> input_queue(lookahead);
+            zbounded_queue<zarray> output_queue(lookahead);
+            std::exception_ptr prefetch_error;
+            std::exception_ptr compute_error;
+            std::exception_ptr write_error;
+
+            std::thread prefetcher([&]()
+            {
+                try
+                {
+                    for (; read_it != chunk_end; ++read_it)
+                    {
+                        std::vector<zarray> chunks;
+                        chunks.reserve(leaves.size());
+                        for (std::size_t i = 0; i < leaves.size(); ++i)
+                        {
+                            zarray::implementation_ptr buffer(zarray_impl_register::get(leaves[i]->get_class_index()).clone());
+                            zchunked_iterator leaf_iter;
+                            if (leaf_grids[i] != nullptr)
+                            {
+                                leaf_iter = zchunked_iterator(*leaf_grids[i], read_it.chunk_index());
+                            }
+                            zchunk_read_args args = {leaf_grids[i] != nullptr ? &leaf_iter : nullptr, &(read_it.get_slice_vector())};
+                            zchunk_read_dispatcher::dispatch(*leaves[i], *buffer, args);
+                            chunks.emplace_back(std::move(buffer));
+                        }
+                        if (!input_queue.push(std::move(chunks)))
+                        {
+                            break;
+                        }
+                    }
+                }
+                catch (...)
+                {
+                    prefetch_error = std::current_exception();
+                }
+                input_queue.close();
+            });
+
+            auto write_back = [&]()
+            {
+                try
+                {
+                    // A zarray holding an implementation is assigned by copying
+                    // the values, each chunk is popped in a new zarray
+                    while (true)
+                    {
+                        zarray chunk;
+                        if (!output_queue.pop(chunk))
+                        {
+                            break;
+                        }
+                        zchunk_write_dispatcher::dispatch(chunk.get_implementation(), res.get_implementation(), write_it);
+                        ++write_it;
+                    }
+                }
+                catch (...)
+                {
+                    write_error = std::current_exception();
+                }
+                output_queue.close();
+            };
+
+            // The prefetch thread must be joined before unwinding
+            // if the write-back thread cannot be started
+            std::thread writer;
+            try
+            {
+                writer = std::thread(write_back);
+            }
+            catch (...)
+            {
+                input_queue.close();
+                prefetcher.join();
+                throw;
+            }
+
+            try
+            {
+                std::vector<zarray> chunks;
+                zchunked_iterator compute_it = arr.chunk_begin();
+                while (input_queue.pop(chunks))
+                {
+                    ZARRAY_TRACE_SCOPE(trace, "chunk", std::string("chunk"));
+                    ZARRAY_TRACE_ARGS(trace, zchunk_trace_args(compute_it));
+                    std::size_t pos = 0;
+                    auto chunk_expression = node_type::rebind(e, chunks, pos);
+                    zarray chunk(chunk_expression);
+                    ++compute_it;
+                    if (!output_queue.push(std::move(chunk)))
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                compute_error = std::current_exception();
+            }
+            // Stops the prefetch stage if the computation has been interrupted
+            input_queue.close();
+            output_queue.close();
+            prefetcher.join();
+            writer.join();
+
+            for (const auto& error : {prefetch_error, compute_error, write_error})
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+    }
+
+    template <class E>
+    inline void pipelined_assign(zarray& res, const xexpression<E>& e, std::size_t lookahead)
+    {
+        if (!res.get_implementation().is_chunked())
+        {
+            throw std::runtime_error("pipelined_assign: result must be a chunked array");
+        }
+        if (lookahead == 0)
+        {
+            throw std::runtime_error("pipelined_assign: lookahead must be positive");
+        }
+        const E& de = e.derived_cast();
+        if (de.shape() != res.shape())
+        {
+            throw std::runtime_error("pipelined_assign: result and expression shapes differ");
+        }
+        detail::pipelined_assign_impl(res, de, lookahead, detail::zchunk_pipeline_node<E>());
+    }
+}
+
+#endif
@@ -10,229 +10,610 @@
 #ifndef XTENSOR_ZCHUNKED_ITERATOR_HPP
 #define XTENSOR_ZCHUNKED_ITERATOR_HPP
 
-#include <memory>
-
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <xtensor/xshape.hpp>
 #include <xtensor/xstrided_view.hpp>
 
 namespace xt
 {
+    // Order in which the chunks of a grid are visited. Morton (Z-order)
+    // and Hilbert orders visit neighbouring chunks close together.
+    enum class zchunk_traversal
+    {
+        row_major,
+        morton,
+        hilbert
+    };
+
+    /***************
+     * zchunk_grid *
+     ***************/
+
+    // Row-major grid of chunks. The first chunk of a dimension can be
+    // truncated by an offset, as in views whose bounds are not aligned
+    // on the chunks of the underlying array: the chunk c of a dimension
+    // covers [c * chunk_size - offset, (c + 1) * chunk_size - offset)
+    // clipped to the bounds of the array.
+    class zchunk_grid
+    {
+    public:
+
+        using shape_type = dynamic_shape<std::size_t>;
+
+        zchunk_grid() = default;
+
+        template <class S1, class S2>
+        zchunk_grid(const S1& shape, const S2& chunk_shape);
+
+        template <class S1, class S2, class S3>
+        zchunk_grid(const S1& shape, const S2& chunk_shape, const S3& offset);
+
+        std::size_t dimension() const;
+        const shape_type& shape() const;
+        const shape_type& chunk_shape() const;
+        const shape_type& offset() const;
+        const shape_type& grid_shape() const;
+        std::size_t size() const;
+
+        std::size_t chunk_start(std::size_t dim, std::size_t coord) const;
+        std::size_t chunk_stop(std::size_t dim, std::size_t coord) const;
+        std::size_t chunk_index(const shape_type& coords) const;
+        void chunk_coords(std::size_t chunk_index, shape_type& coords) const;
+
+        void resize(std::size_t dim, std::size_t extent);
+
+        zchunk_traversal traversal() const;
+        void set_traversal(zchunk_traversal traversal);
+
+        std::uint64_t curve_code(const shape_type& coords) const;
+
+        std::size_t traversal_rank(std::size_t chunk_index) const;
+        std::size_t traversal_chunk(std::size_t rank) const;
+
+    private:
+
+        void init_grid_shape();
+        std::size_t compute_curve_bits(const shape_type& grid_shape) const;
+        void init_traversal();
+
+        shape_type m_shape;
+        shape_type m_chunk_shape;
+        shape_type m_offset;
+        shape_type m_grid_shape;
+        std::size_t m_size = 0;
+        zchunk_traversal m_traversal = zchunk_traversal::row_major;
+        // Bits per dimension of the codes along the space-filling curve
+        std::size_t m_curve_bits = 0;
+        // Row-major indices of the chunks sorted by curve code, their
+        // codes, and position of each chunk in this order; empty in
+        // row-major order
+        std::vector<std::size_t> m_order;
+        std::vector<std::uint64_t> m_codes;
+        std::vector<std::size_t> m_rank;
+    };
 
     /*********************
      * zchunked_iterator *
      *********************/
 
-    class zchunked_iterator_impl;
-
+    // Iterates over the chunks of a zchunk_grid, in the traversal order
+    // of the grid. The iterator only holds the position in the grid:
+    // slices are computed from the grid, and copying the iterator does
+    // not allocate as long as the dimension of the grid fits in the
+    // static storage of dynamic_shape.
     class zchunked_iterator
     {
     public:
-        
-        using implementation_ptr = std::unique_ptr<zchunked_iterator_impl>;
+
+        using shape_type = zchunk_grid::shape_type;
 
         zchunked_iterator() = default;
         ~zchunked_iterator() = default;
-        
-        template <class It>
-        explicit zchunked_iterator(It&& iter);
+
+        zchunked_iterator(const zchunk_grid& grid, std::size_t chunk_index);
 
         zchunked_iterator(const zchunked_iterator&);
         zchunked_iterator& operator=(const zchunked_iterator&);
-        
-        zchunked_iterator(zchunked_iterator&&);
-        zchunked_iterator& operator=(zchunked_iterator&&);
+
+        zchunked_iterator(zchunked_iterator&&) = default;
+        zchunked_iterator& operator=(zchunked_iterator&&) = default;
 
         zchunked_iterator& operator++();
 
         const xstrided_slice_vector& get_slice_vector() const;
         xstrided_slice_vector get_chunk_slice_vector() const;
-
-        template <class It>
-        const It& get_xchunked_iterator() const;
+        std::size_t chunk_index() const;
+        const shape_type& chunk_coords() const;
+        shape_type chunk_extent() const;
 
         bool operator==(const zchunked_iterator& other) const;
         bool operator!=(const zchunked_iterator& other) const;
 
     private:
 
-        implementation_ptr p_impl;
+        void set_end();
+
+        const zchunk_grid* p_grid = nullptr;
+        std::size_t m_chunk_index = 0;
+        shape_type m_coords;
+        // Position in the traversal order of the grid
+        std::size_t m_rank = 0;
+        // Computed on demand and never copied
+        mutable xstrided_slice_vector m_slices;
+        mutable bool m_slices_initialized = false;
     };
 
-    /**************************
-     * zchunked_iterator_impl *
-     **************************/
+    /******************************
+     * zchunk_grid implementation *
+     ******************************/
 
-    class zchunked_iterator_impl
+    template <class S1, class S2>
+    inline zchunk_grid::zchunk_grid(const S1& shape, const S2& chunk_shape)
+        : m_shape(shape.cbegin(), shape.cend())
+        , m_chunk_shape(chunk_shape.cbegin(), chunk_shape.cend())
+        , m_offset(shape.size(), std::size_t(0))
     {
-    public:
-
-        virtual ~zchunked_iterator_impl() = default;
-
-        zchunked_iterator_impl(const zchunked_iterator_impl&) = delete;
-        zchunked_iterator_impl& operator=(const zchunked_iterator_impl&) = delete;
+        init_grid_shape();
+    }
 
-        zchunked_iterator_impl(zchunked_iterator_impl&&) = delete;
-        zchunked_iterator_impl& operator=(zchunked_iterator_impl&&) = delete;
+    template <class S1, class S2, class S3>
+    inline zchunk_grid::zchunk_grid(const S1& shape, const S2& chunk_shape, const S3& offset)
+        : m_shape(shape.cbegin(), shape.cend())
+        , m_chunk_shape(chunk_shape.cbegin(), chunk_shape.cend())
+        , m_offset(offset.cbegin(), offset.cend())
+    {
+        init_grid_shape();
+    }
 
-        virtual zchunked_iterator_impl* clone() const = 0;
+    inline std::size_t zchunk_grid::dimension() const
+    {
+        return m_shape.size();
+    }
 
-        virtual void increment() = 0;
-        virtual const xstrided_slice_vector& get_slice_vector() const = 0;
-        virtual xstrided_slice_vector get_chunk_slice_vector() const = 0;
+    inline auto zchunk_grid::shape() const -> const shape_type&
+    {
+        return m_shape;
+    }
 
-        virtual bool equal(const zchunked_iterator_impl& other) const = 0;
+    inline auto zchunk_grid::chunk_shape() const -> const shape_type&
+    {
+        return m_chunk_shape;
+    }
 
-    protected:
+    inline auto zchunk_grid::offset() const -> const shape_type&
+    {
+        return m_offset;
+    }
 
-        zchunked_iterator_impl() = default;
-    };
+    inline auto zchunk_grid::grid_shape() const -> const shape_type&
+    {
+        return m_grid_shape;
+    }
 
-    /***************************
-     * zchunk_iterator_wrapper *
-     ***************************/
+    // Number of chunks
+    inline std::size_t zchunk_grid::size() const
+    {
+        return m_size;
+    }
 
-    template <class It>
-    class zchunked_iterator_wrapper : public zchunked_iterator_impl
+    inline std::size_t zchunk_grid::chunk_start(std::size_t dim, std::size_t coord) const
     {
-    public:
+        std::size_t start = coord * m_chunk_shape[dim];
+        return start > m_offset[dim] ? start - m_offset[dim] : std::size_t(0);
+    }
 
-        template <class OIT>
-        explicit zchunked_iterator_wrapper(OIT&& it);
+    inline std::size_t zchunk_grid::chunk_stop(std::size_t dim, std::size_t coord) const
+    {
+        return (std::min)((coord + 1) * m_chunk_shape[dim] - m_offset[dim], m_shape[dim]);
+    }
 
-        virtual ~zchunked_iterator_wrapper() = default;
+    // Row-major linear index of the chunk with the given coordinates
+    inline std::size_t zchunk_grid::chunk_index(const shape_type& coords) const
+    {
+        std::size_t res = 0;
+        for (std::size_t d = 0; d < coords.size(); ++d)
+        {
+            res = res * m_grid_shape[d] + coords[d];
+        }
+        return res;
+    }
 
-        zchunked_iterator_wrapper* clone() const override;
-        
-        void increment() override;
-        const xstrided_slice_vector& get_slice_vector() const override;
-        xstrided_slice_vector get_chunk_slice_vector() const override;
+    inline void zchunk_grid::chunk_coords(std::size_t chunk_index, shape_type& coords) const
+    {
+        coords.resize(dimension());
+        for (std::size_t d = coords.size(); d != 0; --d)
+        {
+            coords[d - 1] = chunk_index % m_grid_shape[d - 1];
+            chunk_index /= m_grid_shape[d - 1];
+        }
+    }
 
-        const It& get_xchunked_iterator() const;
+    // Changes the extent of the grid along a dimension. When chunks
+    // are added and the codes of the existing ones do not change, only
+    // the codes of the new chunks are computed and sorted, then merged
+    // into the traversal order.
+    inline void zchunk_grid::resize(std::size_t dim, std::size_t extent)
+    {
+        shape_type grid_shape(m_grid_shape);
+        grid_shape[dim] = extent == 0 ? 0 : (extent + m_offset[dim] + m_chunk_shape[dim] - 1) / m_chunk_shape[dim];
+        std::size_t curve_bits = compute_curve_bits(grid_shape);
+        if (m_traversal != zchunk_traversal::row_major && dimension() * curve_bits > 63u)
+        {
+            throw std::runtime_error("chunk grid too large for a space-filling curve traversal");
+        }
 
-        bool equal(const zchunked_iterator_impl& other) const override;
+        m_shape[dim] = extent;
+        if (grid_shape[dim] == m_grid_shape[dim])
+        {
+            return;
+        }
 
-    private:
+        // Morton codes do not depend on the number of bits, Hilbert ones do
+        bool keep_codes = grid_shape[dim] > m_grid_shape[dim] &&
+                          (m_traversal == zchunk_traversal::morton || curve_bits == m_curve_bits);
+        shape_type old_grid_shape(m_grid_shape);
+        m_grid_shape = std::move(grid_shape);
+        m_size = 1u;
+        for (std::size_t d = 0; d < m_grid_shape.size(); ++d)
+        {
+            m_size *= m_grid_shape[d];
+        }
+        m_curve_bits = curve_bits;
+        if (m_traversal == zchunk_traversal::row_major || !keep_codes)
+        {
+            init_traversal();
+            return;
+        }
 
-        It m_iterator;
-    };
+        std::vector<std::pair<std::uint64_t, std::size_t>> added;
+        added.reserve(m_size - m_order.size());
+        shape_type coords;
+        for (std::size_t i = 0; i < m_size; ++i)
+        {
+            chunk_coords(i, coords);
+            if (coords[dim] >= old_grid_shape[dim])
+            {
+                added.emplace_back(curve_code(coords), i);
+            }
+        }
+        std::sort(added.begin(), added.end());
+
+        // Existing chunks keep their rank relative to each other, only
+        // their row-major index changes
+        std::vector<std::size_t> order;
+        std::vector<std::uint64_t> codes;
+        order.reserve(m_size);
+        codes.reserve(m_size);
+        auto added_it = added.cbegin();
+        for (std::size_t r = 0; r < m_order.size(); ++r)
+        {
+            for (; added_it != added.cend() && added_it->first < m_codes[r]; ++added_it)
+            {
+                codes.push_back(added_it->first);
+                order.push_back(added_it->second);
+            }
+            std::size_t index = m_order[r];
+            for (std::size_t d = coords.size(); d != 0; --d)
+            {
+                coords[d - 1] = index % old_grid_shape[d - 1];
+                index /= old_grid_shape[d - 1];
+            }
+            codes.push_back(m_codes[r]);
+            order.push_back(chunk_index(coords));
+        }
+        for (; added_it != added.cend(); ++added_it)
+        {
+            codes.push_back(added_it->first);
+            order.push_back(added_it->second);
+        }
 
-    /************************************
-     * zchunked_iterator implementation *
-     ************************************/
+        m_order = std::move(order);
+        m_codes = std::move(codes);
+        m_rank.resize(m_size);
+        for (std::size_t r = 0; r < m_size; ++r)
+        {
+            m_rank[m_order[r]] = r;
+        }
+    }
 
-    template <class It>
-    inline zchunked_iterator::zchunked_iterator(It&& iter)
-        : p_impl(new zchunked_iterator_wrapper<std::decay_t<It>>(std::forward<It>(iter)))
+    inline zchunk_traversal zchunk_grid::traversal() const
     {
+        return m_traversal;
     }
 
-    inline zchunked_iterator::zchunked_iterator(const zchunked_iterator& rhs)
-        : p_impl(rhs.p_impl->clone())
+    inline void zchunk_grid::set_traversal(zchunk_traversal traversal)
     {
+        if (traversal != zchunk_traversal::row_major && dimension() * m_curve_bits > 63u)
+        {
+            throw std::runtime_error("chunk grid too large for a space-filling curve traversal");
+        }
+        m_traversal = traversal;
+        init_traversal();
     }
 
-    inline zchunked_iterator& zchunked_iterator::operator=(const zchunked_iterator& rhs)
+    // The code interleaves the bits of the coordinates (or of their
+    // Hilbert transform), the most significant bit coming from the
+    // first dimension.
+    inline std::uint64_t zchunk_grid::curve_code(const shape_type& coords) const
     {
-        zchunked_iterator tmp(rhs);
-        tmp.p_impl.swap(p_impl);
-        return *this;
+        std::size_t dim = dimension();
+        shape_type x(coords);
+        if (m_traversal == zchunk_traversal::hilbert && m_curve_bits != 0)
+        {
+            // Axes to transpose, from J. Skilling, "Programming the Hilbert curve"
+            std::size_t m = std::size_t(1) << (m_curve_bits - 1);
+            for (std::size_t q = m; q > 1; q >>= 1)
+            {
+                std::size_t p = q - 1;
+                for (std::size_t i = 0; i < dim; ++i)
+                {
+                    if (x[i] & q)
+                    {
+                        x[0] ^= p;
+                    }
+                    else
+                    {
+                        std::size_t t = (x[0] ^ x[i]) & p;
+                        x[0] ^= t;
+                        x[i] ^= t;
+                    }
+                }
+            }
+            for (std::size_t i = 1; i < dim; ++i)
+            {
+                x[i] ^= x[i - 1];
+            }
+            std::size_t t = 0;
+            for (std::size_t q = m; q > 1; q >>= 1)
+            {
+                if (x[dim - 1] & q)
+                {
+                    t ^= q - 1;
+                }
+            }
+            for (std::size_t i = 0; i < dim; ++i)
+            {
+                x[i] ^= t;
+            }
+        }
+        std::uint64_t code = 0;
+        for (std::size_t b = m_curve_bits; b != 0; --b)
+        {
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                code = (code << 1) | ((x[d] >> (b - 1)) & 1u);
+            }
+        }
+        return code;
     }
-        
-    inline zchunked_iterator::zchunked_iterator(zchunked_iterator&& rhs)
-        : p_impl(std::move(rhs.p_impl))
+
+    // Position of a chunk in the traversal order
+    inline std::size_t zchunk_grid::traversal_rank(std::size_t chunk_index) const
     {
+        return m_rank.empty() ? chunk_index : m_rank[chunk_index];
     }
 
-    inline zchunked_iterator& zchunked_iterator::operator=(zchunked_iterator&& rhs)
+    // Row-major index of the chunk at the given position of the
+    // traversal order
+    inline std::size_t zchunk_grid::traversal_chunk(std::size_t rank) const
     {
-        rhs.p_impl.swap(p_impl);
-        return *this;
+        return m_order.empty() ? rank : m_order[rank];
     }
 
-    inline zchunked_iterator& zchunked_iterator::operator++()
+    inline void zchunk_grid::init_grid_shape()
     {
-        p_impl->increment();
-        return *this;
+        m_grid_shape.resize(m_shape.size());
+        m_size = 1u;
+        for (std::size_t d = 0; d < m_shape.size(); ++d)
+        {
+            m_grid_shape[d] = m_shape[d] == 0 ? 0 : (m_shape[d] + m_offset[d] + m_chunk_shape[d] - 1) / m_chunk_shape[d];
+            m_size *= m_grid_shape[d];
+        }
+        m_curve_bits = compute_curve_bits(m_grid_shape);
+        init_traversal();
     }
 
-    inline const xstrided_slice_vector& zchunked_iterator::get_slice_vector() const
+    inline std::size_t zchunk_grid::compute_curve_bits(const shape_type& grid_shape) const
     {
-        return p_impl->get_slice_vector();
+        std::size_t max_extent = 1u;
+        for (std::size_t d = 0; d < grid_shape.size(); ++d)
+        {
+            max_extent = (std::max)(max_extent, grid_shape[d]);
+        }
+        std::size_t curve_bits = 0;
+        while ((std::size_t(1) << curve_bits) < max_extent)
+        {
+            ++curve_bits;
+        }
+        return curve_bits;
     }
 
-    inline xstrided_slice_vector zchunked_iterator::get_chunk_slice_vector() const
+    // Only the codes of the chunks are computed and sorted: enumerating
+    // the power-of-two bounding grid of the curve would take time
+    // proportional to its size, which is unbounded for elongated grids.
+    inline void zchunk_grid::init_traversal()
     {
-        return p_impl->get_chunk_slice_vector();
+        m_order.clear();
+        m_codes.clear();
+        m_rank.clear();
+        if (m_traversal == zchunk_traversal::row_major)
+        {
+            return;
+        }
+        std::vector<std::pair<std::uint64_t, std::size_t>> codes(m_size);
+        shape_type coords;
+        for (std::size_t i = 0; i < m_size; ++i)
+        {
+            chunk_coords(i, coords);
+            codes[i] = std::make_pair(curve_code(coords), i);
+        }
+        std::sort(codes.begin(), codes.end());
+        m_order.resize(m_size);
+        m_codes.resize(m_size);
+        m_rank.resize(m_size);
+        for (std::size_t r = 0; r < m_size; ++r)
+        {
+            m_order[r] = codes[r].second;
+            m_codes[r] = codes[r].first;
+            m_rank[codes[r].second] = r;
+        }
     }
 
-    template <class It>
-    const It& zchunked_iterator::get_xchunked_iterator() const
+    /************************************
+     * zchunked_iterator implementation *
+     ************************************/
+
+    // Iterator on the chunk of the given row-major index. The chunk of
+    // index 0 is the first chunk of every traversal order.
+    inline zchunked_iterator::zchunked_iterator(const zchunk_grid& grid, std::size_t chunk_index)
+        : p_grid(&grid)
+        , m_chunk_index(chunk_index)
+        , m_coords(grid.dimension(), std::size_t(0))
     {
-        const auto& impl = static_cast<const zchunked_iterator_wrapper<It>&>(*p_impl);
-        return impl.get_xchunked_iterator();
+        if (chunk_index >= grid.size())
+        {
+            set_end();
+        }
+        else
+        {
+            grid.chunk_coords(chunk_index, m_coords);
+            m_rank = grid.traversal_rank(chunk_index);
+        }
     }
 
-    inline bool zchunked_iterator::operator==(const zchunked_iterator& other) const
+    inline zchunked_iterator::zchunked_iterator(const zchunked_iterator& rhs)
+        : p_grid(rhs.p_grid)
+        , m_chunk_index(rhs.m_chunk_index)
+        , m_coords(rhs.m_coords)
+        , m_rank(rhs.m_rank)
+        , m_slices()
+        , m_slices_initialized(false)
     {
-        return p_impl->equal(*(other.p_impl));
     }
 
-    inline bool zchunked_iterator::operator!=(const zchunked_iterator& other) const
+    // Keeps the storage of the slices of this iterator
+    inline zchunked_iterator& zchunked_iterator::operator=(const zchunked_iterator& rhs)
     {
-        return !(*this == other);
+        p_grid = rhs.p_grid;
+        m_chunk_index = rhs.m_chunk_index;
+        m_coords = rhs.m_coords;
+        m_rank = rhs.m_rank;
+        m_slices_initialized = false;
+        return *this;
     }
 
-    /********************************************
-     * zchunked_iterator_wrapper implementation *
-     ********************************************/
-
-    template <class It>
-    template <class OIT>
-    inline zchunked_iterator_wrapper<It>::zchunked_iterator_wrapper(OIT&& it)
-        : m_iterator(std::forward<OIT>(it))
+    inline zchunked_iterator& zchunked_iterator::operator++()
     {
+        m_slices_initialized = false;
+        if (p_grid->traversal() == zchunk_traversal::row_major)
+        {
+            ++m_chunk_index;
+            const auto& grid_shape = p_grid->grid_shape();
+            std::size_t d = m_coords.size();
+            while (d != 0)
+            {
+                --d;
+                if (++m_coords[d] != grid_shape[d] || d == 0)
+                {
+                    break;
+                }
+                m_coords[d] = 0;
+            }
+            ++m_rank;
+            return *this;
+        }
+        if (++m_rank < p_grid->size())
+        {
+            m_chunk_index = p_grid->traversal_chunk(m_rank);
+            p_grid->chunk_coords(m_chunk_index, m_coords);
+        }
+        else
+        {
+            set_end();
+        }
+        return *this;
     }
 
-    template <class It>
-    inline zchunked_iterator_wrapper<It>* zchunked_iterator_wrapper<It>::clone() const
+    // Slices of the current chunk in the array
+    inline const xstrided_slice_vector& zchunked_iterator::get_slice_vector() const
     {
-        return new zchunked_iterator_wrapper(m_iterator);
+        if (!m_slices_initialized)
+        {
+            m_slices.resize(m_coords.size());
+            for (std::size_t d = 0; d < m_coords.size(); ++d)
+            {
+                auto start = static_cast<std::ptrdiff_t>(p_grid->chunk_start(d, m_coords[d]));
+                auto stop = static_cast<std::ptrdiff_t>(p_grid->chunk_stop(d, m_coords[d]));
+                m_slices[d] = xt::range(start, stop);
+            }
+            m_slices_initialized = true;
+        }
+        return m_slices;
     }
-        
-    template <class It>
-    inline void zchunked_iterator_wrapper<It>::increment()
+
+    // Slices of the part of the current chunk within the array bounds,
+    // relative to the chunk
+    inline xstrided_slice_vector zchunked_iterator::get_chunk_slice_vector() const
     {
-        ++m_iterator;
+        xstrided_slice_vector res(m_coords.size());
+        for (std::size_t d = 0; d < m_coords.size(); ++d)
+        {
+            std::size_t start = p_grid->chunk_start(d, m_coords[d]);
+            std::size_t stop = p_grid->chunk_stop(d, m_coords[d]);
+            std::size_t lo = start + p_grid->offset()[d] - m_coords[d] * p_grid->chunk_shape()[d];
+            res[d] = xt::range(static_cast<std::ptrdiff_t>(lo), static_cast<std::ptrdiff_t>(lo + stop - start));
+        }
+        return res;
     }
 
-    template <class It>
-    inline const xstrided_slice_vector& zchunked_iterator_wrapper<It>::get_slice_vector() const
+    // Linear index of the current chunk in the row-major chunk grid
+    inline std::size_t zchunked_iterator::chunk_index() const
     {
-        return m_iterator.get_slice_vector();
+        return m_chunk_index;
     }
-    
-    template <class It>
-    inline xstrided_slice_vector zchunked_iterator_wrapper<It>::get_chunk_slice_vector() const
+
+    inline auto zchunked_iterator::chunk_coords() const -> const shape_type&
     {
-        return m_iterator.get_chunk_slice_vector();
+        return m_coords;
     }
 
-    template <class It>
-    inline const It& zchunked_iterator_wrapper<It>::get_xchunked_iterator() const
+    // Shape of the part of the current chunk within the array bounds
+    inline auto zchunked_iterator::chunk_extent() const -> shape_type
     {
-        return m_iterator;
+        shape_type res(m_coords.size());
+        for (std::size_t d = 0; d < m_coords.size(); ++d)
+        {
+            res[d] = p_grid->chunk_stop(d, m_coords[d]) - p_grid->chunk_start(d, m_coords[d]);
+        }
+        return res;
     }
 
-    template <class It>
-    inline bool zchunked_iterator_wrapper<It>::equal(const zchunked_iterator_impl& other) const
+    inline void zchunked_iterator::set_end()
     {
-        const auto* tmp = dynamic_cast<const zchunked_iterator_wrapper<It>*>(&other);
-        if (tmp != nullptr)
+        m_chunk_index = p_grid->size();
+        std::fill(m_coords.begin(), m_coords.end(), std::size_t(0));
+        if (!m_coords.empty())
         {
-            return m_iterator == tmp->m_iterator;
+            m_coords[0] = p_grid->grid_shape()[0];
         }
-        return false;
+        m_rank = p_grid->size();
+    }
+
+    inline bool zchunked_iterator::operator==(const zchunked_iterator& other) const
+    {
+        return p_grid == other.p_grid && m_chunk_index == other.m_chunk_index;
+    }
+
+    inline bool zchunked_iterator::operator!=(const zchunked_iterator& other) const
+    {
+        return !(*this == other);
     }
 }
 
 #endif
-
@@ -0,0 +1,724 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XTENSOR_ZCHUNKED_VIEW_WRAPPER_HPP
+#define XTENSOR_ZCHUNKED_VIEW_WRAPPER_HPP
+
+#include <vector>
+
+#include "zchunked_wrapper.hpp"
+
+namespace xt
+{
+    namespace detail
+    {
+        /**************
+         * zbox_slice *
+         **************/
+
+        // Selection of a slice along one dimension; is_box is false when
+        // the slice does not select a non empty contiguous range.
+        struct zbox_slice
+        {
+            bool is_box;
+            bool keep_dim;
+            std::size_t start;
+            std::size_t size;
+        };
+
+        class zbox_slice_visitor
+        {
+        public:
+
+            explicit zbox_slice_visitor(std::size_t dim_size);
+
+            void operator()(std::ptrdiff_t index);
+            void operator()(xall_tag);
+
+            template <class A, class B, class C>
+            void operator()(const xrange_adaptor<A, B, C>& range);
+
+            template <class S>
+            void operator()(const S&);
+
+            const zbox_slice& result() const;
+
+        private:
+
+            std::size_t m_dim_size;
+            zbox_slice m_result;
+        };
+
+        /***************
+         * zview_chunk *
+         ***************/
+
+        // Intersection of a view with a chunk of the viewed array
+        struct zview_chunk
+        {
+            zchunked_iterator parent_iter;
+            // slices of the intersection in the chunk of the viewed array
+            xstrided_slice_vector chunk_slices;
+            dynamic_shape<std::size_t> extent;
+            bool is_full;
+        };
+    }
+
+    /*************************
+     * zchunked_view_wrapper *
+     *************************/
+
+    // View over a contiguous box of a chunked array. Only the chunks
+    // intersecting the box are read or written, and the view is itself
+    // chunked: its chunks are the intersections of the box with the
+    // chunks of the viewed array.
+    template <class T>
+    class zchunked_view_wrapper : public ztyped_chunked_array<T>
+    {
+    public:
+
+        using self_type = zchunked_view_wrapper;
+        using base_type = ztyped_chunked_array<T>;
+        using value_type = T;
+        using shape_type = zchunked_array::shape_type;
+        using slice_vector = typename base_type::slice_vector;
+
+        zchunked_view_wrapper(ztyped_chunked_array<T>& parent, const std::vector<detail::zbox_slice>& box);
+
+        virtual ~zchunked_view_wrapper() = default;
+
+        bool is_array() const override;
+        bool is_chunked() const override;
+        bool owns_buffer() const override;
+
+        xarray<value_type>& get_array() override;
+        const xarray<value_type>& get_array() const override;
+        xarray<value_type> get_chunk(const slice_vector& slices) const override;
+
+        self_type* clone() const override;
+        std::ostream& print(std::ostream& out) const override;
+
+        zarray_impl* strided_view(slice_vector& slices) override;
+
+        const nlohmann::json& get_metadata() const override;
+        void set_metadata(const nlohmann::json& metadata) override;
+        std::size_t dimension() const override;
+        const shape_type& shape() const override;
+        void reshape(const shape_type&) override;
+        void reshape(shape_type&&) override;
+        void resize(const shape_type&) override;
+        void resize(shape_type&&) override;
+        bool broadcast_shape(shape_type& shape, bool reuse_cache = 0) const override;
+
+        const shape_type& chunk_shape() const override;
+        size_t grid_size() const override;
+
+        const zchunk_grid& chunk_grid() const override;
+        zchunked_iterator chunk_begin() const override;
+        zchunked_iterator chunk_end() const override;
+
+        zchunk_traversal traversal_order() const override;
+        void set_traversal_order(zchunk_traversal order) override;
+
+        bool has_fill_value() const override;
+        bool is_fill_chunk(std::size_t index) const override;
+
+        bool has_chunk_statistics() const override;
+
+        bool has_aligned_chunks() const override;
+        std::size_t chunk_version(std::size_t index) const override;
+
+        bool is_incremental() const override;
+        void set_incremental(bool incremental) override;
+        bool is_chunk_up_to_date(std::size_t index, const std::vector<std::size_t>& input_key) const override;
+        void set_chunk_input_key(std::size_t index, std::vector<std::size_t>&& input_key) override;
+
+        void assign_chunk(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it) override;
+        xarray<value_type> read_chunk(const zchunked_iterator& chunk_it) const override;
+
+        void set_fill_value(const value_type& value) override;
+        const value_type& chunk_fill_value(std::size_t index) const override;
+        void assign_fill_chunk(const value_type& value, const zchunked_iterator& chunk_it) override;
+
+        void enable_chunk_statistics() override;
+        const zchunk_statistics<value_type>& chunk_statistics(std::size_t index) const override;
+
+    private:
+
+        zchunked_view_wrapper(const zchunked_view_wrapper&) = default;
+
+        void compute_cache() const;
+        bool is_full_chunk(const detail::zview_chunk& chunk) const;
+
+        ztyped_chunked_array<T>* p_parent;
+        shape_type m_shape;
+        shape_type m_chunk_shape;
+        zchunk_grid m_grid;
+        std::vector<detail::zview_chunk> m_chunks;
+        bool m_aligned_chunks;
+        mutable xarray<value_type> m_cache;
+        mutable bool m_cache_initialized;
+        zmetadata<value_type> m_metadata;
+    };
+
+    /*************************************
+     * zbox_slice_visitor implementation *
+     *************************************/
+
+    namespace detail
+    {
+        inline zbox_slice_visitor::zbox_slice_visitor(std::size_t dim_size)
+            : m_dim_size(dim_size)
+            , m_result{false, true, 0u, 0u}
+        {
+        }
+
+        inline void zbox_slice_visitor::operator()(std::ptrdiff_t index)
+        {
+            std::ptrdiff_t dim_size = static_cast<std::ptrdiff_t>(m_dim_size);
+            std::ptrdiff_t i = index < 0 ? index + dim_size : index;
+            m_result = zbox_slice{i >= 0 && i < dim_size, false, static_cast<std::size_t>(i), 1u};
+        }
+
+        inline void zbox_slice_visitor::operator()(xall_tag)
+        {
+            m_result = zbox_slice{m_dim_size != 0, true, 0u, m_dim_size};
+        }
+
+        template <class A, class B, class C>
+        inline void zbox_slice_visitor::operator()(const xrange_adaptor<A, B, C>& range)
+        {
+            auto r = range.get(m_dim_size);
+            std::size_t size = r.size();
+            bool is_box = size != 0 && (size == 1 || r.step_size() == 1);
+            m_result = zbox_slice{is_box, true, is_box ? static_cast<std::size_t>(r(0)) : 0u, size};
+        }
+
+        // newaxis and ellipsis
+        template <class S>
+        inline void zbox_slice_visitor::operator()(const S&)
+        {
+            m_result = zbox_slice{false, true, 0u, 0u};
+        }
+
+        inline const zbox_slice& zbox_slice_visitor::result() const
+        {
+            return m_result;
+        }
+
+        template <class T>
+        inline zarray_impl* build_chunked_view(ztyped_chunked_array<T>& parent, const xstrided_slice_vector& slices)
+        {
+            const auto& shape = parent.shape();
+            if (slices.size() > shape.size())
+            {
+                return nullptr;
+            }
+            std::vector<zbox_slice> box(shape.size());
+            for (std::size_t d = 0; d < shape.size(); ++d)
+            {
+                zbox_slice_visitor visitor(shape[d]);
+                if (d < slices.size())
+                {
+                    xtl::visit(visitor, slices[d]);
+                }
+                else
+                {
+                    visitor(xall_tag());
+                }
+                box[d] = visitor.result();
+                if (!box[d].is_box)
+                {
+                    return nullptr;
+                }
+            }
+            return new zchunked_view_wrapper<T>(parent, box);
+        }
+
+        template <class T>
+        inline bool read_chunked_box(const ztyped_chunked_array<T>& arr, const xstrided_slice_vector& slices, xarray<T>& res)
+        {
+            const auto& shape = arr.shape();
+            std::size_t dim = shape.size();
+            if (slices.size() > dim)
+            {
+                return false;
+            }
+            dynamic_shape<std::size_t> start(dim), stop(dim), res_shape(dim);
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                zbox_slice_visitor visitor(shape[d]);
+                if (d < slices.size())
+                {
+                    xtl::visit(visitor, slices[d]);
+                }
+                else
+                {
+                    visitor(xall_tag());
+                }
+                const zbox_slice& box = visitor.result();
+                if (!box.is_box || !box.keep_dim)
+                {
+                    return false;
+                }
+                start[d] = box.start;
+                stop[d] = box.start + box.size;
+                res_shape[d] = box.size;
+            }
+            res.resize(res_shape);
+
+            // Coordinates of the first and last chunks intersecting the box
+            const zchunk_grid& grid = arr.chunk_grid();
+            dynamic_shape<std::size_t> first(dim), last(dim), coords(dim);
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                first[d] = (start[d] + grid.offset()[d]) / grid.chunk_shape()[d];
+                last[d] = (stop[d] - 1u + grid.offset()[d]) / grid.chunk_shape()[d];
+                coords[d] = first[d];
+            }
+
+            xstrided_slice_vector chunk_slices(dim), res_slices(dim);
+            while (true)
+            {
+                xarray<T> chunk = arr.read_chunk(zchunked_iterator(grid, grid.chunk_index(coords)));
+                for (std::size_t d = 0; d < dim; ++d)
+                {
+                    std::size_t chunk_start = grid.chunk_start(d, coords[d]);
+                    std::size_t lo = (std::max)(chunk_start, start[d]);
+                    std::size_t hi = (std::min)(grid.chunk_stop(d, coords[d]), stop[d]);
+                    chunk_slices[d] = xt::range(lo - chunk_start, hi - chunk_start);
+                    res_slices[d] = xt::range(lo - start[d], hi - start[d]);
+                }
+                xt::noalias(xt::strided_view(res, res_slices)) = xt::strided_view(chunk, chunk_slices);
+
+                std::size_t d = dim;
+                while (d != 0 && coords[d - 1] == last[d - 1])
+                {
+                    coords[d - 1] = first[d - 1];
+                    --d;
+                }
+                if (d == 0)
+                {
+                    break;
+                }
+                ++coords[d - 1];
+            }
+            return true;
+        }
+    }
+
+    /****************************************
+     * zchunked_view_wrapper implementation *
+     ****************************************/
+
+    template <class T>
+    inline zchunked_view_wrapper<T>::zchunked_view_wrapper(ztyped_chunked_array<T>& parent,
+                                                           const std::vector<detail::zbox_slice>& box)
+        : base_type()
+        , p_parent(&parent)
+        , m_aligned_chunks(parent.has_aligned_chunks())
+        , m_cache()
+        , m_cache_initialized(false)
+    {
+        const zchunk_grid& parent_grid = parent.chunk_grid();
+        const auto& parent_chunk_shape = parent.chunk_shape();
+        const auto& parent_offset = parent_grid.offset();
+        std::size_t dim = parent_grid.dimension();
+
+        // Range of chunk coordinates intersecting the box in each dimension
+        std::vector<std::size_t> first(dim), last(dim);
+        shape_type offset;
+        for (std::size_t d = 0; d < dim; ++d)
+        {
+            std::size_t chunk_size = parent_chunk_shape[d];
+            first[d] = (box[d].start + parent_offset[d]) / chunk_size;
+            last[d] = (box[d].start + parent_offset[d] + box[d].size - 1) / chunk_size;
+            if (box[d].keep_dim)
+            {
+                m_shape.push_back(box[d].size);
+                m_chunk_shape.push_back(chunk_size);
+                offset.push_back((box[d].start + parent_offset[d]) % chunk_size);
+                m_aligned_chunks = m_aligned_chunks && box[d].start % chunk_size == 0;
+            }
+        }
+
+        m_grid = zchunk_grid(m_shape, m_chunk_shape, offset);
+
+        // The intersecting chunks of the parent are visited in row-major
+        // order, which is the row-major order of the view chunk grid,
+        // whatever the traversal order of the parent.
+        zchunk_grid::shape_type coords(first.cbegin(), first.cend());
+        bool done = m_grid.size() == 0;
+        while (!done)
+        {
+            zchunked_iterator it(parent_grid, parent_grid.chunk_index(coords));
+            detail::zview_chunk chunk = {it, {}, {}, true};
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                std::size_t chunk_start = parent_grid.chunk_start(d, coords[d]);
+                std::size_t chunk_stop = parent_grid.chunk_stop(d, coords[d]);
+                std::size_t lo = (std::max)(box[d].start, chunk_start);
+                std::size_t hi = (std::min)(box[d].start + box[d].size, chunk_stop);
+                chunk.is_full = chunk.is_full && lo == chunk_start && hi == chunk_stop;
+                if (box[d].keep_dim)
+                {
+                    chunk.chunk_slices.push_back(xt::range(lo - chunk_start, hi - chunk_start));
+                    chunk.extent.push_back(hi - lo);
+                }
+                else
+                {
+                    chunk.chunk_slices.push_back(static_cast<std::ptrdiff_t>(lo - chunk_start));
+                }
+            }
+            m_chunks.push_back(std::move(chunk));
+
+            done = true;
+            for (std::size_t d = dim; d != 0; --d)
+            {
+                if (coords[d - 1] != last[d - 1])
+                {
+                    ++coords[d - 1];
+                    done = false;
+                    break;
+                }
+                coords[d - 1] = first[d - 1];
+            }
+        }
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::is_array() const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::is_chunked() const
+    {
+        return true;
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::owns_buffer() const
+    {
+        return false;
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::get_array() -> xarray<value_type>&
+    {
+        this->update_version();
+        compute_cache();
+        return m_cache;
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::get_array() const -> const xarray<value_type>&
+    {
+        compute_cache();
+        return m_cache;
+    }
+
+    // See zchunked_wrapper::get_chunk
+    template <class T>
+    auto zchunked_view_wrapper<T>::get_chunk(const slice_vector& slices) const -> xarray<value_type>
+    {
+        xarray<value_type> res;
+        if (!m_cache_initialized && detail::read_chunked_box(*this, slices, res))
+        {
+            return res;
+        }
+        compute_cache();
+        return xt::strided_view(m_cache, slices);
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::clone() const -> self_type*
+    {
+        return new self_type(*this);
+    }
+
+    template <class T>
+    std::ostream& zchunked_view_wrapper<T>::print(std::ostream& out) const
+    {
+        return out << get_array();
+    }
+
+    template <class T>
+    zarray_impl* zchunked_view_wrapper<T>::strided_view(slice_vector& slices)
+    {
+        this->update_version();
+        zarray_impl* view = detail::build_chunked_view<value_type>(*this, slices);
+        if (view != nullptr)
+        {
+            return view;
+        }
+        // Other slices apply to the values of the view, assigning
+        // the result is not reflected in the viewed array.
+        auto e = xt::strided_view(get_array(), slices);
+        return detail::build_zarray(std::move(e));
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::get_metadata() const -> const nlohmann::json&
+    {
+        return m_metadata.get();
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::set_metadata(const nlohmann::json& metadata)
+    {
+        m_metadata.set(metadata);
+    }
+
+    template <class T>
+    std::size_t zchunked_view_wrapper<T>::dimension() const
+    {
+        return m_shape.size();
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::shape() const -> const shape_type&
+    {
+        return m_shape;
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::reshape(const shape_type&)
+    {
+        // No op
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::reshape(shape_type&&)
+    {
+        // No op
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::resize(const shape_type&)
+    {
+        // See zchunked_wrapper::resize
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::resize(shape_type&&)
+    {
+        // See zchunked_wrapper::resize
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::broadcast_shape(shape_type& shape, bool) const
+    {
+        return xt::broadcast_shape(m_shape, shape);
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::chunk_shape() const -> const shape_type&
+    {
+        return m_chunk_shape;
+    }
+
+    template <class T>
+    size_t zchunked_view_wrapper<T>::grid_size() const
+    {
+        return m_chunks.size();
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::chunk_grid() const -> const zchunk_grid&
+    {
+        return m_grid;
+    }
+
+    template <class T>
+    zchunked_iterator zchunked_view_wrapper<T>::chunk_begin() const
+    {
+        return zchunked_iterator(m_grid, 0u);
+    }
+
+    template <class T>
+    zchunked_iterator zchunked_view_wrapper<T>::chunk_end() const
+    {
+        return zchunked_iterator(m_grid, m_grid.size());
+    }
+
+    template <class T>
+    zchunk_traversal zchunked_view_wrapper<T>::traversal_order() const
+    {
+        return m_grid.traversal();
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::set_traversal_order(zchunk_traversal order)
+    {
+        m_grid.set_traversal(order);
+    }
+
+    // The chunks of a view are generally not aligned with the chunks
+    // of an array of the same shape, fill chunks and statistics of
+    // the viewed array are therefore not exposed.
+    template <class T>
+    bool zchunked_view_wrapper<T>::has_fill_value() const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::is_fill_chunk(std::size_t) const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::has_chunk_statistics() const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::has_aligned_chunks() const
+    {
+        return m_aligned_chunks;
+    }
+
+    // Assigning the parts of the parent chunk outside of the view
+    // also changes the version of the view chunk
+    template <class T>
+    std::size_t zchunked_view_wrapper<T>::chunk_version(std::size_t index) const
+    {
+        return p_parent->chunk_version(m_chunks[index].parent_iter.chunk_index());
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::is_incremental() const
+    {
+        return false;
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::set_incremental(bool)
+    {
+        throw std::runtime_error("chunked view cannot be assigned incrementally");
+    }
+
+    template <class T>
+    bool zchunked_view_wrapper<T>::is_chunk_up_to_date(std::size_t, const std::vector<std::size_t>&) const
+    {
+        return false;
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::set_chunk_input_key(std::size_t, std::vector<std::size_t>&&)
+    {
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::assign_chunk(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it)
+    {
+        this->update_version();
+        const detail::zview_chunk& chunk = m_chunks[chunk_it.chunk_index()];
+        if (is_full_chunk(chunk))
+        {
+            p_parent->assign_chunk(std::move(rhs), chunk.parent_iter);
+        }
+        else
+        {
+            xarray<value_type> tmp = p_parent->read_chunk(chunk.parent_iter);
+            xt::noalias(xt::strided_view(tmp, chunk.chunk_slices)) = rhs;
+            p_parent->assign_chunk(std::move(tmp), chunk.parent_iter);
+        }
+        m_cache_initialized = false;
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::read_chunk(const zchunked_iterator& chunk_it) const -> xarray<value_type>
+    {
+        const detail::zview_chunk& chunk = m_chunks[chunk_it.chunk_index()];
+        xarray<value_type> tmp = p_parent->read_chunk(chunk.parent_iter);
+        if (is_full_chunk(chunk))
+        {
+            return tmp;
+        }
+        return xt::strided_view(tmp, chunk.chunk_slices);
+    }
+
+    // Fills the viewed region of the array
+    template <class T>
+    void zchunked_view_wrapper<T>::set_fill_value(const value_type& value)
+    {
+        this->update_version();
+        auto chunk_end = this->chunk_end();
+        for (auto it = this->chunk_begin(); it != chunk_end; ++it)
+        {
+            assign_fill_chunk(value, it);
+        }
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::chunk_fill_value(std::size_t) const -> const value_type&
+    {
+        throw std::runtime_error("chunked view does not track fill chunks");
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::assign_fill_chunk(const value_type& value, const zchunked_iterator& chunk_it)
+    {
+        this->update_version();
+        const detail::zview_chunk& chunk = m_chunks[chunk_it.chunk_index()];
+        if (is_full_chunk(chunk))
+        {
+            p_parent->assign_fill_chunk(value, chunk.parent_iter);
+            m_cache_initialized = false;
+        }
+        else
+        {
+            auto tmp = xarray<value_type>::from_shape(chunk.extent);
+            tmp.fill(value);
+            assign_chunk(std::move(tmp), chunk_it);
+        }
+    }
+
+    template <class T>
+    void zchunked_view_wrapper<T>::enable_chunk_statistics()
+    {
+        throw std::runtime_error("chunked view does not maintain chunk statistics");
+    }
+
+    template <class T>
+    auto zchunked_view_wrapper<T>::chunk_statistics(std::size_t) const -> const zchunk_statistics<value_type>&
+    {
+        throw std::runtime_error("chunked view does not maintain chunk statistics");
+    }
+
+    template <class T>
+    inline void zchunked_view_wrapper<T>::compute_cache() const
+    {
+        if (!m_cache_initialized)
+        {
+            m_cache.resize(m_shape);
+            auto chunk_end = this->chunk_end();
+            for (auto it = this->chunk_begin(); it != chunk_end; ++it)
+            {
+                xt::noalias(xt::strided_view(m_cache, it.get_slice_vector())) = read_chunk(it);
+            }
+            m_cache_initialized = true;
+        }
+    }
+
+    // A view chunk covering a whole chunk of the viewed array can be
+    // read and written without slicing, unless the view drops dimensions.
+    template <class T>
+    inline bool zchunked_view_wrapper<T>::is_full_chunk(const detail::zview_chunk& chunk) const
+    {
+        return chunk.is_full && m_shape.size() == p_parent->dimension();
+    }
+}
+
+#endif
@@ -10,6 +10,12 @@
 #ifndef XTENSOR_ZCHUNKED_WRAPPER_HPP
 #define XTENSOR_ZCHUNKED_WRAPPER_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <vector>
+
 #include "zarray_impl.hpp"
 #include "zchunked_iterator.hpp"
 
@@ -29,8 +35,47 @@ namespace xt
         virtual const shape_type& chunk_shape() const = 0;
         virtual size_t grid_size() const = 0;
 
+        virtual const zchunk_grid& chunk_grid() const = 0;
         virtual zchunked_iterator chunk_begin() const = 0;
         virtual zchunked_iterator chunk_end() const = 0;
+
+        // Order of the chunks between chunk_begin() and chunk_end(), and
+        // therefore of the chunk loops of assignments and reductions
+        virtual zchunk_traversal traversal_order() const = 0;
+        virtual void set_traversal_order(zchunk_traversal order) = 0;
+
+        virtual bool has_fill_value() const = 0;
+        virtual bool is_fill_chunk(std::size_t index) const = 0;
+
+        virtual bool has_chunk_statistics() const = 0;
+
+        // True when the chunk i covers the i-th cell of the row-major
+        // grid of chunk_shape() starting at the origin of the array
+        virtual bool has_aligned_chunks() const = 0;
+
+        // Version stamps are unique among all chunked arrays, a chunk
+        // gets a new one each time it is assigned
+        virtual std::size_t chunk_version(std::size_t index) const = 0;
+
+        // In incremental mode, a chunk is not recomputed when assigned
+        // an expression whose input chunks have not changed since its
+        // last computation
+        virtual bool is_incremental() const = 0;
+        virtual void set_incremental(bool incremental) = 0;
+        virtual bool is_chunk_up_to_date(std::size_t index, const std::vector<std::size_t>& input_key) const = 0;
+        virtual void set_chunk_input_key(std::size_t index, std::vector<std::size_t>&& input_key) = 0;
+    };
+
+    // Summary of the values of a chunk. NaN values are counted as nulls
+    // and excluded from min and max, which are meaningless when every
+    // value of the chunk is null.
+    template <class T>
+    struct zchunk_statistics
+    {
+        T min;
+        T max;
+        std::size_t null_count;
+        std::size_t size;
     };
 
     template <class T>
@@ -44,8 +89,124 @@ namespace xt
         virtual ~ztyped_chunked_array() = default;
 
         virtual void assign_chunk(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it) = 0;
+        virtual xarray<value_type> read_chunk(const zchunked_iterator& chunk_it) const = 0;
+
+        virtual void set_fill_value(const value_type& value) = 0;
+        virtual const value_type& chunk_fill_value(std::size_t index) const = 0;
+        virtual void assign_fill_chunk(const value_type& value, const zchunked_iterator& chunk_it) = 0;
+
+        virtual void enable_chunk_statistics() = 0;
+        virtual const zchunk_statistics<value_type>& chunk_statistics(std::size_t index) const = 0;
     };
 
+    namespace detail
+    {
+        // Chunks that have never been written since fill tracking was
+        // enabled hold a single value and are never read from the storage.
+        template <class T>
+        struct zchunk_state
+        {
+            bool is_fill;
+            T fill_value;
+            zchunk_statistics<T> statistics;
+        };
+
+        inline std::size_t next_chunk_version()
+        {
+            static std::atomic<std::size_t> version(0);
+            return ++version;
+        }
+
+        // Versions of the inputs a chunk has been computed from,
+        // and version of the chunk resulting from this computation
+        struct zchunk_input_key
+        {
+            std::vector<std::size_t> inputs;
+            std::size_t version;
+        };
+
+        template <class T>
+        inline bool is_null_value(const T& v)
+        {
+            // NaN is the only value that does not compare equal to itself
+            return v != v;
+        }
+
+        template <class T>
+        inline zchunk_statistics<T> fill_chunk_statistics(const T& value, std::size_t size)
+        {
+            return is_null_value(value) ? zchunk_statistics<T>{T(), T(), size, size}
+                                        : zchunk_statistics<T>{value, value, 0u, size};
+        }
+
+        template <class T, class E>
+        inline zchunk_statistics<T> compute_chunk_statistics(const E& e)
+        {
+            zchunk_statistics<T> res = {T(), T(), 0u, 0u};
+            bool first = true;
+            for (auto it = e.cbegin(); it != e.cend(); ++it)
+            {
+                T v = *it;
+                ++res.size;
+                if (is_null_value(v))
+                {
+                    ++res.null_count;
+                }
+                else if (first)
+                {
+                    res.min = v;
+                    res.max = v;
+                    first = false;
+                }
+                else
+                {
+                    res.min = (std::min)(res.min, v);
+                    res.max = (std::max)(res.max, v);
+                }
+            }
+            return res;
+        }
+
+        // Shape of the chunk at the given linear index of the row-major
+        // chunk grid; edge chunks are truncated to the array bounds.
+        template <class S1, class S2>
+        inline dynamic_shape<std::size_t> chunk_extent(const S1& shape, const S2& chunk_shape, std::size_t index)
+        {
+            std::size_t dim = shape.size();
+            dynamic_shape<std::size_t> res(dim);
+            for (std::size_t i = dim; i != 0; --i)
+            {
+                std::size_t d = i - 1;
+                std::size_t grid_dim = (shape[d] + chunk_shape[d] - 1) / chunk_shape[d];
+                std::size_t pos = index % grid_dim;
+                index /= grid_dim;
+                res[d] = (std::min)(chunk_shape[d], shape[d] - pos * chunk_shape[d]);
+            }
+            return res;
+        }
+
+        template <class S1, class S2>
+        inline std::size_t chunk_size(const S1& shape, const S2& chunk_shape, std::size_t index)
+        {
+            auto extent = chunk_extent(shape, chunk_shape, index);
+            return std::accumulate(extent.cbegin(), extent.cend(), std::size_t(1), std::multiplies<std::size_t>());
+        }
+    }
+
+    namespace detail
+    {
+        // Returns a zchunked_view_wrapper when the slices select a box
+        // of the array, nullptr otherwise
+        template <class T>
+        zarray_impl* build_chunked_view(ztyped_chunked_array<T>& parent, const xstrided_slice_vector& slices);
+
+        // Reads the box selected by the slices from the chunks intersecting
+        // it only. Returns false when the slices do not select a box with
+        // the dimension of the array.
+        template <class T>
+        bool read_chunked_box(const ztyped_chunked_array<T>& arr, const xstrided_slice_vector& slices, xarray<T>& res);
+    }
+
     template <class CTE>
     class zchunked_wrapper : public ztyped_chunked_array<typename std::decay_t<CTE>::value_type>
     {
@@ -64,6 +225,7 @@ namespace xt
 
         bool is_array() const override;
         bool is_chunked() const override;
+        bool owns_buffer() const override;
 
         xarray<value_type>& get_array() override;
         const xarray<value_type>& get_array() const override;
@@ -87,16 +249,45 @@ namespace xt
         const shape_type& chunk_shape() const override;
         size_t grid_size() const override;
 
+        const zchunk_grid& chunk_grid() const override;
         zchunked_iterator chunk_begin() const override;
         zchunked_iterator chunk_end() const override;
 
+        zchunk_traversal traversal_order() const override;
+        void set_traversal_order(zchunk_traversal order) override;
+
+        bool has_fill_value() const override;
+        bool is_fill_chunk(std::size_t index) const override;
+
+        bool has_chunk_statistics() const override;
+
+        bool has_aligned_chunks() const override;
+        std::size_t chunk_version(std::size_t index) const override;
+
+        bool is_incremental() const override;
+        void set_incremental(bool incremental) override;
+        bool is_chunk_up_to_date(std::size_t index, const std::vector<std::size_t>& input_key) const override;
+        void set_chunk_input_key(std::size_t index, std::vector<std::size_t>&& input_key) override;
+
         void assign_chunk(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it) override;
+        xarray<value_type> read_chunk(const zchunked_iterator& chunk_it) const override;
+
+        void set_fill_value(const value_type& value) override;
+        const value_type& chunk_fill_value(std::size_t index) const override;
+        void assign_fill_chunk(const value_type& value, const zchunked_iterator& chunk_it) override;
+
+        void enable_chunk_statistics() override;
+        const zchunk_statistics<value_type>& chunk_statistics(std::size_t index) const override;
 
     private:
 
+        using chunk_state = detail::zchunk_state<value_type>;
+
         zchunked_wrapper(const zchunked_wrapper&) = default;
 
         void compute_cache() const;
+        void materialize_fill_chunks();
+        void update_chunk_statistics(const xarray<value_type>& rhs, std::size_t index);
 
         template <class CT = CTE>
         detail::enable_const_t<CT> assign_chunk_impl(xarray<value_type>&& rhs,
@@ -108,12 +299,21 @@ namespace xt
 
         CTE m_chunked_array;
         shape_type m_chunk_shape;
+        zchunk_grid m_grid;
         mutable xarray<value_type> m_cache;
         mutable bool m_cache_initialized;
         mutable dynamic_shape<std::ptrdiff_t> m_strides;
         mutable bool m_strides_initialized;
 
-        nlohmann::json m_metadata;
+        bool m_has_fill_value;
+        bool m_has_chunk_statistics;
+        std::vector<chunk_state> m_chunk_states;
+
+        std::vector<std::size_t> m_chunk_versions;
+        bool m_incremental;
+        std::vector<detail::zchunk_input_key> m_input_keys;
+
+        zmetadata<value_type> m_metadata;
     };
 
     /***********************************
@@ -126,14 +326,20 @@ namespace xt
         : base_type()
         , m_chunked_array(std::forward<E>(e))
         , m_chunk_shape(m_chunked_array.chunk_shape().size())
+        , m_grid(m_chunked_array.shape(), m_chunked_array.chunk_shape())
         , m_cache()
         , m_cache_initialized(false)
         , m_strides_initialized(false)
+        , m_has_fill_value(false)
+        , m_has_chunk_statistics(false)
+        , m_chunk_states()
+        , m_chunk_versions(m_chunked_array.grid_size(), detail::next_chunk_version())
+        , m_incremental(false)
+        , m_input_keys()
     {
         std::copy(m_chunked_array.chunk_shape().begin(),
                   m_chunked_array.chunk_shape().end(),
                   m_chunk_shape.begin());
-        detail::set_data_type<value_type>(m_metadata);
     }
 
     template <class CTE>
@@ -148,9 +354,16 @@ namespace xt
         return true;
     }
 
+    template <class CTE>
+    bool zchunked_wrapper<CTE>::owns_buffer() const
+    {
+        return false;
+    }
+
     template <class CTE>
     auto zchunked_wrapper<CTE>::get_array() -> xarray<value_type>&
     {
+        this->update_version();
         compute_cache();
         return m_cache;
     }
@@ -162,9 +375,16 @@ namespace xt
         return m_cache;
     }
 
+    // Only the chunks intersecting the slices are read,
+    // unless the whole array is already cached
     template <class CTE>
     auto zchunked_wrapper<CTE>::get_chunk(const slice_vector& slices) const -> xarray<value_type>
     {
+        xarray<value_type> res;
+        if (!m_cache_initialized && detail::read_chunked_box(*this, slices, res))
+        {
+            return res;
+        }
         compute_cache();
         return xt::strided_view(m_cache, slices);
     }
@@ -178,12 +398,25 @@ namespace xt
     template <class CTE>
     std::ostream& zchunked_wrapper<CTE>::print(std::ostream& out) const
     {
+        if (m_has_fill_value)
+        {
+            return out << get_array();
+        }
         return out << m_chunked_array;
     }
 
     template <class CTE>
     zarray_impl* zchunked_wrapper<CTE>::strided_view(slice_vector& slices)
     {
+        this->update_version();
+        zarray_impl* view = detail::build_chunked_view<value_type>(*this, slices);
+        if (view != nullptr)
+        {
+            return view;
+        }
+        // The view accesses the storage directly, which therefore
+        // must hold the actual values of the fill chunks
+        materialize_fill_chunks();
         auto e = xt::strided_view(m_chunked_array, slices);
         return detail::build_zarray(std::move(e));
     }
@@ -191,13 +424,13 @@ namespace xt
     template <class CTE>
     auto zchunked_wrapper<CTE>::get_metadata() const -> const nlohmann::json&
     {
-        return m_metadata;
+        return m_metadata.get();
     }
 
     template <class CTE>
     void zchunked_wrapper<CTE>::set_metadata(const nlohmann::json& metadata)
     {
-        m_metadata = metadata;
+        m_metadata.set(metadata);
     }
 
     template <class CTE>
@@ -260,22 +493,230 @@ namespace xt
         return m_chunk_shape;
     }
 
+    template <class CTE>
+    auto zchunked_wrapper<CTE>::chunk_grid() const -> const zchunk_grid&
+    {
+        return m_grid;
+    }
+
     template <class CTE>
     zchunked_iterator zchunked_wrapper<CTE>::chunk_begin() const
     {
-        return zchunked_iterator(m_chunked_array.chunk_begin());
+        return zchunked_iterator(m_grid, 0u);
     }
 
     template <class CTE>
     zchunked_iterator zchunked_wrapper<CTE>::chunk_end() const
     {
-        return zchunked_iterator(m_chunked_array.chunk_end());
+        return zchunked_iterator(m_grid, m_grid.size());
+    }
+
+    template <class CTE>
+    zchunk_traversal zchunked_wrapper<CTE>::traversal_order() const
+    {
+        return m_grid.traversal();
+    }
+
+    template <class CTE>
+    void zchunked_wrapper<CTE>::set_traversal_order(zchunk_traversal order)
+    {
+        m_grid.set_traversal(order);
+    }
+
+    template <class CTE>
+    bool zchunked_wrapper<CTE>::has_fill_value() const
+    {
+        return m_has_fill_value;
+    }
+
+    template <class CTE>
+    bool zchunked_wrapper<CTE>::is_fill_chunk(std::size_t index) const
+    {
+        return m_has_fill_value && m_chunk_states[index].is_fill;
+    }
+
+    template <class CTE>
+    bool zchunked_wrapper<CTE>::has_chunk_statistics() const
+    {
+        return m_has_chunk_statistics;
+    }
+
+    template <class CTE>
+    bool zchunked_wrapper<CTE>::has_aligned_chunks() const
+    {
+        return true;
+    }
+
+    template <class CTE>
+    std::size_t zchunked_wrapper<CTE>::chunk_version(std::size_t index) const
+    {
+        return m_chunk_versions[index];
+    }
+
+    template <class CTE>
+    bool zchunked_wrapper<CTE>::is_incremental() const
+    {
+        return m_incremental;
+    }
+
+    template <class CTE>
+    void zchunked_wrapper<CTE>::set_incremental(bool incremental)
+    {
+        m_incremental = incremental;
+        if (incremental)
+        {
+            m_input_keys.assign(grid_size(), detail::zchunk_input_key{{}, 0u});
+        }
+        else
+        {
+            m_input_keys.clear();
+        }
+    }
+
+    // A chunk assigned by other means than the incremental assignment
+    // has a new version, it is therefore recomputed
+    template <class CTE>
+    bool zchunked_wrapper<CTE>::is_chunk_up_to_date(std::size_t index, const std::vector<std::size_t>& input_key) const
+    {
+        const detail::zchunk_input_key& key = m_input_keys[index];
+        return key.version == m_chunk_versions[index] && key.inputs == input_key;
+    }
+
+    template <class CTE>
+    void zchunked_wrapper<CTE>::set_chunk_input_key(std::size_t index, std::vector<std::size_t>&& input_key)
+    {
+        m_input_keys[index] = detail::zchunk_input_key{std::move(input_key), m_chunk_versions[index]};
     }
 
     template <class CTE>
     void zchunked_wrapper<CTE>::assign_chunk(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it)
     {
+        this->update_version();
+        if (m_has_chunk_statistics)
+        {
+            update_chunk_statistics(rhs, chunk_it.chunk_index());
+        }
         assign_chunk_impl(std::move(rhs), chunk_it);
+        if (m_has_fill_value)
+        {
+            m_chunk_states[chunk_it.chunk_index()].is_fill = false;
+        }
+        m_chunk_versions[chunk_it.chunk_index()] = detail::next_chunk_version();
+        m_cache_initialized = false;
+    }
+
+    template <class CTE>
+    auto zchunked_wrapper<CTE>::read_chunk(const zchunked_iterator& chunk_it) const -> xarray<value_type>
+    {
+        std::size_t index = chunk_it.chunk_index();
+        if (is_fill_chunk(index))
+        {
+            auto res = xarray<value_type>::from_shape(detail::chunk_extent(shape(), m_chunk_shape, index));
+            res.fill(m_chunk_states[index].fill_value);
+            return res;
+        }
+        const auto& coords = chunk_it.chunk_coords();
+        const auto& chunk = m_chunked_array.chunks().element(coords.cbegin(), coords.cend());
+        return xt::strided_view(chunk, chunk_it.get_chunk_slice_vector());
+    }
+
+    // Declares that every chunk holds the given value. From now on, chunks
+    // assigned a constant value through zarray kernels are not written to
+    // the storage anymore. Writing to the wrapped chunked array directly
+    // after this call is not tracked.
+    template <class CTE>
+    void zchunked_wrapper<CTE>::set_fill_value(const value_type& value)
+    {
+        this->update_version();
+        if (detail::is_const<CTE>::value)
+        {
+            throw std::runtime_error("const array is not assignable");
+        }
+        std::size_t size = grid_size();
+        m_chunk_states.resize(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            auto statistics = detail::fill_chunk_statistics(value, detail::chunk_size(shape(), m_chunk_shape, i));
+            m_chunk_states[i] = chunk_state{true, value, statistics};
+        }
+        m_chunk_versions.assign(size, detail::next_chunk_version());
+        m_has_fill_value = true;
+        m_cache_initialized = false;
+    }
+
+    template <class CTE>
+    auto zchunked_wrapper<CTE>::chunk_fill_value(std::size_t index) const -> const value_type&
+    {
+        return m_chunk_states[index].fill_value;
+    }
+
+    template <class CTE>
+    void zchunked_wrapper<CTE>::assign_fill_chunk(const value_type& value, const zchunked_iterator& chunk_it)
+    {
+        this->update_version();
+        if (m_has_fill_value)
+        {
+            std::size_t index = chunk_it.chunk_index();
+            auto statistics = detail::fill_chunk_statistics(value, detail::chunk_size(shape(), m_chunk_shape, index));
+            m_chunk_states[index] = chunk_state{true, value, statistics};
+            m_chunk_versions[index] = detail::next_chunk_version();
+            m_cache_initialized = false;
+        }
+        else
+        {
+            auto tmp = xarray<value_type>::from_shape(m_chunk_shape);
+            tmp.fill(value);
+            assign_chunk(std::move(tmp), chunk_it);
+        }
+    }
+
+    // Computes the statistics of every chunk and keeps them up to date on
+    // subsequent chunk assignments. As for fill chunks, writing to the
+    // wrapped chunked array directly is not tracked.
+    template <class CTE>
+    void zchunked_wrapper<CTE>::enable_chunk_statistics()
+    {
+        if (!m_has_fill_value)
+        {
+            m_chunk_states.assign(grid_size(), chunk_state{false, value_type(), {}});
+        }
+        auto chunk_end = this->chunk_end();
+        for (auto it = this->chunk_begin(); it != chunk_end; ++it)
+        {
+            std::size_t index = it.chunk_index();
+            chunk_state& state = m_chunk_states[index];
+            state.statistics = is_fill_chunk(index)
+                ? detail::fill_chunk_statistics(state.fill_value, detail::chunk_size(shape(), m_chunk_shape, index))
+                : detail::compute_chunk_statistics<value_type>(read_chunk(it));
+        }
+        m_has_chunk_statistics = true;
+    }
+
+    template <class CTE>
+    auto zchunked_wrapper<CTE>::chunk_statistics(std::size_t index) const -> const zchunk_statistics<value_type>&
+    {
+        return m_chunk_states[index].statistics;
+    }
+
+    template <class CTE>
+    inline void zchunked_wrapper<CTE>::update_chunk_statistics(const xarray<value_type>& rhs, std::size_t index)
+    {
+        // Edge chunks may be assigned a full chunk, only the part
+        // within the array bounds is taken into account.
+        auto extent = detail::chunk_extent(shape(), m_chunk_shape, index);
+        if (std::equal(extent.cbegin(), extent.cend(), rhs.shape().cbegin(), rhs.shape().cend()))
+        {
+            m_chunk_states[index].statistics = detail::compute_chunk_statistics<value_type>(rhs);
+        }
+        else
+        {
+            xstrided_slice_vector slices;
+            for (auto e : extent)
+            {
+                slices.push_back(xt::range(std::size_t(0), e));
+            }
+            m_chunk_states[index].statistics = detail::compute_chunk_statistics<value_type>(xt::strided_view(rhs, slices));
+        }
     }
 
     template <class CTE>
@@ -284,11 +725,51 @@ namespace xt
         if (!m_cache_initialized)
         {
             m_cache.resize(m_chunked_array.shape());
-            as_chunked(m_cache,  m_chunked_array.chunk_shape()) = m_chunked_array;
+            if (m_has_fill_value)
+            {
+                std::size_t index = 0;
+                auto chunk_end = m_chunked_array.chunk_end();
+                for (auto it = m_chunked_array.chunk_begin(); it != chunk_end; ++it, ++index)
+                {
+                    auto dst = xt::strided_view(m_cache, it.get_slice_vector());
+                    if (m_chunk_states[index].is_fill)
+                    {
+                        std::fill(dst.begin(), dst.end(), m_chunk_states[index].fill_value);
+                    }
+                    else
+                    {
+                        xt::noalias(dst) = xt::strided_view(*it, it.get_chunk_slice_vector());
+                    }
+                }
+            }
+            else
+            {
+                as_chunked(m_cache,  m_chunked_array.chunk_shape()) = m_chunked_array;
+            }
             m_cache_initialized = true;
         }
     }
 
+    template <class CTE>
+    inline void zchunked_wrapper<CTE>::materialize_fill_chunks()
+    {
+        if (m_has_fill_value)
+        {
+            auto chunk_end = this->chunk_end();
+            for (auto it = this->chunk_begin(); it != chunk_end; ++it)
+            {
+                std::size_t index = it.chunk_index();
+                if (m_chunk_states[index].is_fill)
+                {
+                    auto tmp = xarray<value_type>::from_shape(m_chunk_shape);
+                    tmp.fill(m_chunk_states[index].fill_value);
+                    assign_chunk_impl(std::move(tmp), it);
+                    m_chunk_states[index].is_fill = false;
+                }
+            }
+        }
+    }
+
     template <class CTE>
     template <class CT>
     inline detail::enable_const_t<CT>
@@ -302,15 +783,16 @@ namespace xt
     inline detail::disable_const_t<CT>
     zchunked_wrapper<CTE>::assign_chunk_impl(xarray<value_type>&& rhs, const zchunked_iterator& chunk_it)
     {
-        const auto& it = chunk_it.get_xchunked_iterator<decltype(m_chunked_array.chunk_begin())>();
+        const auto& coords = chunk_it.chunk_coords();
+        auto& chunk = m_chunked_array.chunks().element(coords.cbegin(), coords.cend());
         const auto& chunk_shape = m_chunked_array.chunk_shape();
         if (rhs.shape() != chunk_shape)
         {
-            xt::noalias(xt::strided_view(*it, it.get_chunk_slice_vector())) = rhs;
+            xt::noalias(xt::strided_view(chunk, chunk_it.get_chunk_slice_vector())) = rhs;
         }
         else
         {
-            xt::noalias(*it) = rhs;
+            xt::noalias(chunk) = rhs;
         }
     }
 }
@@ -10,10 +10,16 @@
 #ifndef XTENSOR_ZDISPATCHER_HPP
 #define XTENSOR_ZDISPATCHER_HPP
 
+#include <functional>
+#include <initializer_list>
+#include <numeric>
+
 #include <xtl/xmultimethods.hpp>
 
+#include "zarray_impl_register.hpp"
 #include "zdispatching_types.hpp"
 #include "zfunctors.hpp"
+#include "ztracer.hpp"
 
 namespace xt
 {
@@ -167,6 +173,53 @@ namespace xt
         zrun_dispatcher m_run_dispatcher;
     };
 
+    /*************************
+     * zquadruple_dispatcher *
+     *************************/
+
+    // Quadruple dispatchers are used for ternary operations.
+    // They dispatch on the three arguments and on the result.
+
+    template <class F>
+    class zquadruple_dispatcher
+    {
+    public:
+
+        template <class T1, class T2, class T3, class R>
+        static void insert();
+
+        template <class T1, class T2, class T3, class R, class... U>
+        static void register_dispatching(mpl::vector<mpl::vector<T1, T2, T3, R>, U...>);
+
+        static void init();
+        static void dispatch(const zarray_impl& z1,
+                             const zarray_impl& z2,
+                             const zarray_impl& z3,
+                             zarray_impl& res,
+                             const zassign_args& args);
+        static size_t get_type_index(const zarray_impl& z1, const zarray_impl& z2, const zarray_impl& z3);
+
+    private:
+        static zquadruple_dispatcher& instance();
+
+        zquadruple_dispatcher();
+        ~zquadruple_dispatcher() = default;
+
+        template <class T1, class T2, class T3, class R>
+        void insert_impl();
+
+        template <class T1, class T2, class T3, class R, class...U>
+        inline void register_dispatching_impl(mpl::vector<mpl::vector<T1, T2, T3, R>, U...>);
+        inline void register_dispatching_impl(mpl::vector<>);
+
+        using zfunctor_type = get_zmapped_functor_t<F>;
+        using ztype_dispatcher = ztype_dispatcher_impl<mpl::vector<const zarray_impl, const zarray_impl, const zarray_impl>>;
+        using zrun_dispatcher = zrun_dispatcher_impl<mpl::vector<const zarray_impl, const zarray_impl, const zarray_impl, zarray_impl>>;
+
+        ztype_dispatcher m_type_dispatcher;
+        zrun_dispatcher m_run_dispatcher;
+    };
+
     /***************
      * zdispatcher *
      ***************/
@@ -186,6 +239,12 @@ namespace xt
         using type = ztriple_dispatcher<F>;
     };
 
+    template <class F>
+    struct zdispatcher<F, 3>
+    {
+        using type = zquadruple_dispatcher<F>;
+    };
+
     template <class F, size_t N, size_t M = 0>
     using zdispatcher_t = typename zdispatcher<F, N, M>::type;
 
@@ -289,6 +348,58 @@ namespace xt
         using unary_dispatching_types_t = typename unary_dispatching_types<F>::type;
     }
 
+    /******************
+     * kernel tracing *
+     ******************/
+
+    namespace detail
+    {
+        template <class... A>
+        inline const zassign_args* get_zassign_args(const zassign_args& args, const A&...)
+        {
+            return &args;
+        }
+
+        template <class... A>
+        inline const zassign_args* get_zassign_args(const A&...)
+        {
+            return nullptr;
+        }
+
+        // The bytes touched by a kernel are estimated from the sizes of its
+        // operands; when a chunk is assigned, the operands with the shape of
+        // the result are read on the extent of the chunk only.
+        inline nlohmann::json zkernel_trace_args(std::initializer_list<const zarray_impl*> inputs,
+                                                 const zarray_impl& res,
+                                                 const zassign_args* args)
+        {
+            using shape_type = zarray_impl::shape_type;
+            auto size = [](const shape_type& shape)
+            {
+                return std::accumulate(shape.cbegin(), shape.cend(), std::size_t(1), std::multiplies<std::size_t>());
+            };
+            bool chunk_assign = args != nullptr && args->chunk_assign;
+            shape_type shape = chunk_assign ? args->chunk_iter.chunk_extent() : res.shape();
+            std::size_t res_size = size(shape);
+
+            nlohmann::json input_types = nlohmann::json::array();
+            std::size_t bytes = res_size * zarray_impl_register::value_size(res.get_class_index());
+            for (const zarray_impl* input : inputs)
+            {
+                std::size_t input_size = chunk_assign && input->shape() == res.shape() ? res_size : size(input->shape());
+                input_types.push_back(zarray_impl_register::data_type(input->get_class_index()));
+                bytes += input_size * zarray_impl_register::value_size(input->get_class_index());
+            }
+
+            nlohmann::json trace_args;
+            trace_args["inputs"] = std::move(input_types);
+            trace_args["output"] = zarray_impl_register::data_type(res.get_class_index());
+            trace_args["shape"] = ztrace_shape(shape);
+            trace_args["bytes"] = bytes;
+            return trace_args;
+        }
+    }
+
     /*************************************
      * zdouble_dispatcher implementation *
      *************************************/
@@ -319,7 +430,9 @@ namespace xt
     template<class ... A>
     inline void zdouble_dispatcher<F,URL, UTL>::dispatch(const zarray_impl& z1, zarray_impl& res, A && ... args)
     {
+        ZARRAY_TRACE_SCOPE(trace, "kernel", detail::ztrace_type_name<F>());
         instance().m_run_dispatcher.dispatch(z1, res, std::forward<A>(args) ...);
+        ZARRAY_TRACE_ARGS(trace, detail::zkernel_trace_args({&z1}, res, detail::get_zassign_args(args...)));
     }
 
     // the variance template here is a bit of a hack st. we can use 
@@ -331,15 +444,17 @@ namespace xt
         return instance().m_type_dispatcher.dispatch(z1, std::forward<A>(args) ...);
     }
 
+    // instance and the constructor are not declared inline so that the
+    // extern template declarations of the compiled library suppress them
     template <class F, class URL, class UTL>
-    inline zdouble_dispatcher<F,URL, UTL>& zdouble_dispatcher<F,URL, UTL>::instance()
+    zdouble_dispatcher<F,URL, UTL>& zdouble_dispatcher<F,URL, UTL>::instance()
     {
         static zdouble_dispatcher<F,URL, UTL> inst;
         return inst;
     }
 
     template <class F, class URL, class UTL>
-    inline zdouble_dispatcher<F,URL, UTL>::zdouble_dispatcher()
+    zdouble_dispatcher<F,URL, UTL>::zdouble_dispatcher()
     {
         register_dispatching_impl(detail::unary_dispatching_types_t<F>());
     }
@@ -442,7 +557,9 @@ namespace xt
                                                 zarray_impl& res,
                                                 const zassign_args& args)
     {
+        ZARRAY_TRACE_SCOPE(trace, "kernel", detail::ztrace_type_name<F>());
         instance().m_run_dispatcher.dispatch(z1, z2, res, args);
+        ZARRAY_TRACE_ARGS(trace, detail::zkernel_trace_args({&z1, &z2}, res, &args));
     }
 
     template <class F>
@@ -452,14 +569,14 @@ namespace xt
     }
 
     template <class F>
-    inline ztriple_dispatcher<F>& ztriple_dispatcher<F>::instance()
+    ztriple_dispatcher<F>& ztriple_dispatcher<F>::instance()
     {
         static ztriple_dispatcher<F> inst;
         return inst;
     }
 
     template <class F>
-    inline ztriple_dispatcher<F>::ztriple_dispatcher()
+    ztriple_dispatcher<F>::ztriple_dispatcher()
     {
         register_dispatching_impl(detail::binary_dispatching_types_t<F>());
     }
@@ -472,7 +589,7 @@ namespace xt
         using arg_type2 = const ztyped_array<T2>;
         using res_type = ztyped_array<R>;
         m_run_dispatcher.template insert<arg_type1, arg_type2, res_type>(&zfunctor_type::template run<T1, T2, R>);
-        m_type_dispatcher.template insert<arg_type1, arg_type1>(&zfunctor_type::template index<T1, T2>);
+        m_type_dispatcher.template insert<arg_type1, arg_type2>(&zfunctor_type::template index<T1, T2>);
     }
 
 
@@ -489,6 +606,110 @@ namespace xt
     {
     }
 
+    /****************************************
+     * zquadruple_dispatcher implementation *
+     ****************************************/
+
+    namespace detail
+    {
+        template <class F>
+        struct ternary_dispatching_types
+        {
+            using type = zternary_op_types;
+        };
+
+        template <>
+        struct ternary_dispatching_types<math::fma_fun>
+        {
+            using type = zternary_func_types;
+        };
+
+        template <>
+        struct ternary_dispatching_types<detail::conditional_ternary>
+        {
+            using type = zternary_select_types;
+        };
+
+        template <class F>
+        using ternary_dispatching_types_t = typename ternary_dispatching_types<F>::type;
+    }
+
+    template <class F>
+    template <class T1, class T2, class T3, class R>
+    inline void zquadruple_dispatcher<F>::insert()
+    {
+        instance().template insert_impl<T1, T2, T3, R>();
+    }
+
+    template <class F>
+    template <class T1, class T2, class T3, class R, class... U>
+    inline void zquadruple_dispatcher<F>::register_dispatching(mpl::vector<mpl::vector<T1, T2, T3, R>, U...>)
+    {
+        instance().register_dispatching_impl(mpl::vector<mpl::vector<T1, T2, T3, R>, U...>());
+    }
+
+    template <class F>
+    inline void zquadruple_dispatcher<F>::init()
+    {
+        instance();
+    }
+
+    template <class F>
+    inline void zquadruple_dispatcher<F>::dispatch(const zarray_impl& z1,
+                                                   const zarray_impl& z2,
+                                                   const zarray_impl& z3,
+                                                   zarray_impl& res,
+                                                   const zassign_args& args)
+    {
+        ZARRAY_TRACE_SCOPE(trace, "kernel", detail::ztrace_type_name<F>());
+        instance().m_run_dispatcher.dispatch(z1, z2, z3, res, args);
+        ZARRAY_TRACE_ARGS(trace, detail::zkernel_trace_args({&z1, &z2, &z3}, res, &args));
+    }
+
+    template <class F>
+    inline size_t zquadruple_dispatcher<F>::get_type_index(const zarray_impl& z1, const zarray_impl& z2, const zarray_impl& z3)
+    {
+        return instance().m_type_dispatcher.dispatch(z1, z2, z3);
+    }
+
+    template <class F>
+    zquadruple_dispatcher<F>& zquadruple_dispatcher<F>::instance()
+    {
+        static zquadruple_dispatcher<F> inst;
+        return inst;
+    }
+
+    template <class F>
+    zquadruple_dispatcher<F>::zquadruple_dispatcher()
+    {
+        register_dispatching_impl(detail::ternary_dispatching_types_t<F>());
+    }
+
+    template <class F>
+    template <class T1, class T2, class T3, class R>
+    inline void zquadruple_dispatcher<F>::insert_impl()
+    {
+        using arg_type1 = const ztyped_array<T1>;
+        using arg_type2 = const ztyped_array<T2>;
+        using arg_type3 = const ztyped_array<T3>;
+        using res_type = ztyped_array<R>;
+        m_run_dispatcher.template insert<arg_type1, arg_type2, arg_type3, res_type>(&zfunctor_type::template run<T1, T2, T3, R>);
+        m_type_dispatcher.template insert<arg_type1, arg_type2, arg_type3>(&zfunctor_type::template index<T1, T2, T3>);
+    }
+
+    template <class F>
+    template <class T1, class T2, class T3, class R, class...U>
+    inline void zquadruple_dispatcher<F>::register_dispatching_impl(mpl::vector<mpl::vector<T1, T2, T3, R>, U...>)
+    {
+        insert_impl<T1, T2, T3, R>();
+        register_dispatching_impl(mpl::vector<U...>());
+    }
+
+    template <class F>
+    inline void zquadruple_dispatcher<F>::register_dispatching_impl(mpl::vector<>)
+    {
+    }
+
 }
 
 #endif
@@ -10,8 +10,13 @@
 #ifndef XTENSOR_ZDISPATCHING_TYPES_HPP
 #define XTENSOR_ZDISPATCHING_TYPES_HPP
 
+#include <cstdint>
+#include <type_traits>
+
 #include <xtl/xmeta_utils.hpp>
 
+#include "zarray_config.hpp"
+
 namespace xt
 {
     namespace mpl = xtl::mpl;
@@ -22,6 +27,18 @@ namespace xt
         template <class... L>
         struct concatenate;
 
+        template <>
+        struct concatenate<>
+        {
+            using type = mpl::vector<>;
+        };
+
+        template <class... T>
+        struct concatenate<mpl::vector<T...>>
+        {
+            using type = mpl::vector<T...>;
+        };
+
         template <class... T, class... U>
         struct concatenate<mpl::vector<T...>, mpl::vector<U...>>
         {
@@ -91,17 +108,80 @@ namespace xt
         template<class ...L>
         using pairwise_combinations_t = typename pairwise_combinations_impl<L ...>::type;
     }
+
+    /*****************
+     * enabled types *
+     *****************/
+
+    // Follows the ZARRAY_ENABLE_* flags of zarray_config.hpp; a type
+    // combination is enabled when all of its types are
+    template <class T>
+    struct is_zenabled_type : std::true_type
+    {
+    };
+
+#define ZARRAY_ENABLED_TYPE(TYPE, FLAG)                                   \
+    template <>                                                          \
+    struct is_zenabled_type<TYPE> : std::integral_constant<bool, FLAG != 0> \
+    {                                                                    \
+    }
+
+    ZARRAY_ENABLED_TYPE(uint8_t, ZARRAY_ENABLE_UINT8);
+    ZARRAY_ENABLED_TYPE(int8_t, ZARRAY_ENABLE_INT8);
+    ZARRAY_ENABLED_TYPE(uint16_t, ZARRAY_ENABLE_UINT16);
+    ZARRAY_ENABLED_TYPE(int16_t, ZARRAY_ENABLE_INT16);
+    ZARRAY_ENABLED_TYPE(uint32_t, ZARRAY_ENABLE_UINT32);
+    ZARRAY_ENABLED_TYPE(int32_t, ZARRAY_ENABLE_INT32);
+    ZARRAY_ENABLED_TYPE(uint64_t, ZARRAY_ENABLE_UINT64);
+    ZARRAY_ENABLED_TYPE(int64_t, ZARRAY_ENABLE_INT64);
+    ZARRAY_ENABLED_TYPE(float, ZARRAY_ENABLE_FLOAT);
+    ZARRAY_ENABLED_TYPE(double, ZARRAY_ENABLE_DOUBLE);
+
+#undef ZARRAY_ENABLED_TYPE
+
+    namespace detail
+    {
+        template <bool... B>
+        struct zbool_pack
+        {
+        };
+    }
+
+    template <class... T>
+    struct is_zenabled_type<mpl::vector<T...>>
+        : std::is_same<detail::zbool_pack<true, is_zenabled_type<T>::value...>,
+                       detail::zbool_pack<is_zenabled_type<T>::value..., true>>
+    {
+    };
+
+    namespace detail
+    {
+        template <class L>
+        struct zenabled_types;
+
+        template <class... T>
+        struct zenabled_types<mpl::vector<T...>>
+        {
+            using type = concatenate_t<std::conditional_t<is_zenabled_type<T>::value,
+                                                          mpl::vector<T>,
+                                                          mpl::vector<>>...>;
+        };
+
+        template <class L>
+        using zenabled_types_t = typename zenabled_types<L>::type;
+    }
+
     /***********
      * z types *
      ***********/
 
-    using z_int_types = mpl::vector<uint8_t, int8_t,
-                                    uint16_t, int16_t,
-                                    uint32_t, int32_t,
-                                    uint64_t, int64_t>;
-    using z_small_int_types = mpl::vector<uint8_t, int8_t, uint16_t, int16_t>;
-    using z_big_int_types = mpl::vector<uint32_t, int32_t, uint64_t, int64_t>;
-    using z_float_types = mpl::vector<float, double>;
+    using z_int_types = detail::zenabled_types_t<mpl::vector<uint8_t, int8_t,
+                                                             uint16_t, int16_t,
+                                                             uint32_t, int32_t,
+                                                             uint64_t, int64_t>>;
+    using z_small_int_types = detail::zenabled_types_t<mpl::vector<uint8_t, int8_t, uint16_t, int16_t>>;
+    using z_big_int_types = detail::zenabled_types_t<mpl::vector<uint32_t, int32_t, uint64_t, int64_t>>;
+    using z_float_types = detail::zenabled_types_t<mpl::vector<float, double>>;
 
     using z_types = detail::concatenate_t<z_int_types,
                                           z_float_types>;
@@ -110,6 +190,9 @@ namespace xt
      * unary operation types *
      *************************/
 
+    // The combinations of the operation types are filtered
+    // again since their result types may be disabled
+
     template <class T, class R>
     struct build_unary_impl
     {
@@ -140,27 +223,33 @@ namespace xt
 
     using zunary_ident_types = mpl::transform_t<build_unary_identity_t, z_types>;
 
-    using zunary_func_types = detail::concatenate_t<
-                                  mpl::transform_t<build_unary_identity_t, z_float_types>,
-                                  mpl::transform_t<build_unary_double_t, z_int_types>,
-                                  mpl::transform_t<build_unary_double_t, z_int_types>,
-                                  mpl::transform_t<build_unary_int64_t, z_float_types>
+    using zunary_func_types = detail::zenabled_types_t<
+                                  detail::concatenate_t<
+                                      mpl::transform_t<build_unary_identity_t, z_float_types>,
+                                      mpl::transform_t<build_unary_double_t, z_int_types>,
+                                      mpl::transform_t<build_unary_double_t, z_int_types>,
+                                      mpl::transform_t<build_unary_int64_t, z_float_types>
+                                  >
                               >;
 
-    using zunary_op_types = detail::concatenate_t<
-                                mpl::transform_t<build_unary_identity_t, z_big_int_types>,
-                                mpl::transform_t<build_unary_identity_t, z_float_types>,
-                                mpl::transform_t<build_unary_int32_t, z_small_int_types>
+    using zunary_op_types = detail::zenabled_types_t<
+                                detail::concatenate_t<
+                                    mpl::transform_t<build_unary_identity_t, z_big_int_types>,
+                                    mpl::transform_t<build_unary_identity_t, z_float_types>,
+                                    mpl::transform_t<build_unary_int32_t, z_small_int_types>
+                                >
                             >;
 
-    using zreducer_types = detail::concatenate_t<
-                            mpl::transform_t<build_unary_identity_t, z_big_int_types>,
-                            mpl::transform_t<build_unary_identity_t, z_float_types>,
-                            mpl::transform_t<build_unary_int32_t, z_small_int_types>,
-                            mpl::transform_t<build_unary_double_t, mpl::vector<float>>,
-                            mpl::transform_t<build_unary_double_t, z_small_int_types>,
-                            mpl::transform_t<build_unary_double_t, z_big_int_types>
-                        >;
+    using zreducer_types = detail::zenabled_types_t<
+                               detail::concatenate_t<
+                                   mpl::transform_t<build_unary_identity_t, z_big_int_types>,
+                                   mpl::transform_t<build_unary_identity_t, z_float_types>,
+                                   mpl::transform_t<build_unary_int32_t, z_small_int_types>,
+                                   mpl::transform_t<build_unary_double_t, mpl::vector<float>>,
+                                   mpl::transform_t<build_unary_double_t, z_small_int_types>,
+                                   mpl::transform_t<build_unary_double_t, z_big_int_types>
+                               >
+                           >;
 
     using zunary_bool_func_types = mpl::transform_t<build_unary_bool_t, z_types>;
 
@@ -191,19 +280,48 @@ namespace xt
     template <class T>
     using build_binary_double_t = build_binary_impl_t<T, T, double>;
 
-    using zbinary_func_types = detail::concatenate_t<
-                                   mpl::transform_t<build_binary_identity_t, z_float_types>,
-                                   mpl::transform_t<build_binary_double_t, z_int_types>
+    using zbinary_func_types = detail::zenabled_types_t<
+                                   detail::concatenate_t<
+                                       mpl::transform_t<build_binary_identity_t, z_float_types>,
+                                       mpl::transform_t<build_binary_double_t, z_int_types>
+                                   >
                                >;
 
-    using zbinary_op_types = detail::concatenate_t<
-                                 mpl::transform_t<build_binary_identity_t, z_big_int_types>,
-                                 mpl::transform_t<build_binary_identity_t, z_float_types>,
-                                 mpl::transform_t<build_binary_int32_t, z_small_int_types>
+    using zbinary_op_types = detail::zenabled_types_t<
+                                 detail::concatenate_t<
+                                     mpl::transform_t<build_binary_identity_t, z_big_int_types>,
+                                     mpl::transform_t<build_binary_identity_t, z_float_types>,
+                                     mpl::transform_t<build_binary_int32_t, z_small_int_types>
+                                 >
                              >;
 
     using zbinary_int_op_types = mpl::transform_t<build_binary_identity_t, z_int_types>;
 
+    /***************************
+     * ternary operation types *
+     ***************************/
+
+    template <class T1, class T2, class T3, class R>
+    struct build_ternary_impl
+    {
+        using type = mpl::vector<T1, T2, T3, R>;
+    };
+
+    template <class T1, class T2, class T3, class R>
+    using build_ternary_impl_t = typename build_ternary_impl<T1, T2, T3, R>::type;
+
+    template <class T>
+    using build_ternary_identity_t = build_ternary_impl_t<T, T, T, T>;
+
+    template <class T>
+    using build_ternary_select_t = build_ternary_impl_t<bool, T, T, T>;
+
+    using zternary_func_types = mpl::transform_t<build_ternary_identity_t, z_float_types>;
+
+    using zternary_op_types = mpl::transform_t<build_ternary_identity_t, z_types>;
+
+    using zternary_select_types = mpl::transform_t<build_ternary_select_t, z_types>;
+
 }
 
 #endif
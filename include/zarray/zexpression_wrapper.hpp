@@ -46,6 +46,7 @@ namespace xt
 
         bool is_array() const override;
         bool is_chunked() const override;
+        bool owns_buffer() const override;
 
         xarray<value_type>& get_array() override;
         const xarray<value_type>& get_array() const override;
@@ -99,7 +100,7 @@ namespace xt
         mutable xarray<value_type> m_cache;
         mutable bool m_cache_initialized;
         shape_type m_shape;
-        nlohmann::json m_metadata;
+        zmetadata<value_type> m_metadata;
     };
 
     /**************************************
@@ -115,7 +116,6 @@ namespace xt
         , m_cache_initialized(false)
         , m_shape(m_expression.dimension())
     {
-        detail::set_data_type<value_type>(m_metadata);
         std::copy(m_expression.shape().begin(), m_expression.shape().end(), m_shape.begin());
     }
 
@@ -131,9 +131,16 @@ namespace xt
         return false;
     }
 
+    template <class CTE>
+    bool zexpression_wrapper<CTE>::owns_buffer() const
+    {
+        return false;
+    }
+
     template <class CTE>
     auto zexpression_wrapper<CTE>::get_array() -> xarray<value_type>&
     {
+        this->update_version();
         compute_cache();
         return m_cache;
     }
@@ -154,6 +161,7 @@ namespace xt
     template <class CTE>
     void zexpression_wrapper<CTE>::assign(xarray<value_type>&& rhs)
     {
+        this->update_version();
         assign_impl(std::move(rhs));
     }
 
@@ -172,6 +180,7 @@ namespace xt
     template <class CTE>
     zarray_impl* zexpression_wrapper<CTE>::strided_view(slice_vector& slices)
     {
+        this->update_version();
         return strided_view_impl(slices, detail::is_xstrided_view<CTE>());
     }
 
@@ -192,13 +201,13 @@ namespace xt
     template <class CTE>
     auto zexpression_wrapper<CTE>::get_metadata() const -> const nlohmann::json&
     {
-        return m_metadata;
+        return m_metadata.get();
     }
 
     template <class CTE>
     void zexpression_wrapper<CTE>::set_metadata(const nlohmann::json& metadata)
     {
-        m_metadata = metadata;
+        m_metadata.set(metadata);
     }
 
     template <class CTE>
@@ -228,12 +237,14 @@ namespace xt
     template <class CTE>
     void zexpression_wrapper<CTE>::resize(const shape_type&)
     {
+        this->update_version();
         resize_impl();
     }
 
     template <class CTE>
     void zexpression_wrapper<CTE>::resize(shape_type&&)
     {
+        this->update_version();
         resize_impl();
     }
 
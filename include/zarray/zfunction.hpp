@@ -10,9 +10,13 @@
 #ifndef XTENSOR_ZFUNCTION_HPP
 #define XTENSOR_ZFUNCTION_HPP
 
+#include <array>
+#include <cstring>
 #include <tuple>
 #include <utility>
+#include <vector>
 
+#include "zarray_config.hpp"
 #include "zdispatcher.hpp"
 #include "zarray_impl_register.hpp"
 #include "zarray_temporary_pool.hpp"
@@ -39,10 +43,14 @@ namespace xt
         const shape_type& shape() const;
         bool broadcast_shape(shape_type& shape, bool reuse_cache = false) const;
 
+        const tuple_type& arguments() const;
+        tuple_type& arguments();
+
         std::unique_ptr<zarray_impl> allocate_result() const;
         std::size_t get_result_type_index() const;
         zarray_impl& assign_to(zarray_impl& res, const zassign_args& args) const;
         zarray_impl& assign_to(detail::zarray_temporary_pool & res, const zassign_args& args) const;
+        zarray_impl& consume_to(zarray_impl& res, const zassign_args& args);
     private:
         std::size_t get_result_type_index_impl() const;
         using dispatcher_type = zdispatcher_t<F, sizeof...(CT)>;
@@ -52,6 +60,9 @@ namespace xt
         template <std::size_t... I>
         std::size_t get_result_type_index_impl(std::index_sequence<I...>) const;
 
+        zarray_impl& assign_result(detail::zarray_temporary_pool & temporary_pool, zarray_impl& res, const zassign_args& args) const;
+        zarray_impl& evaluate(detail::zarray_temporary_pool & temporary_pool, const zassign_args& args) const;
+
         template<std::size_t ... I>
         zarray_impl& assign_to_impl(std::index_sequence<I ...>, detail::zarray_temporary_pool & temporary_pool, const zassign_args& args) const;
 
@@ -101,6 +112,39 @@ namespace xt
     
     namespace detail
     {
+        // The address of value is unique per type
+        template <class T>
+        struct ztype_id
+        {
+            static const char value;
+        };
+
+        template <class T>
+        const char ztype_id<T>::value = 0;
+
+        template <class T>
+        inline std::size_t get_type_id()
+        {
+            return reinterpret_cast<std::size_t>(&ztype_id<T>::value);
+        }
+
+        /*****************
+         * lazy operands *
+         *****************/
+
+        // Unevaluated lazy operands with the shape of the result are
+        // evaluated in the temporary pool of the expression, so that
+        // their temporaries and common subexpressions are shared with
+        // it. Their result is kept, later uses read it.
+        inline bool is_inlined_lazy_operand(const zarray_impl& impl, const zarray_temporary_pool& temporary_pool)
+        {
+            return impl.get_lazy_expression() != nullptr && impl.shape() == temporary_pool.shape();
+        }
+
+        inline std::vector<std::size_t> get_lazy_operand_key(const zarray_impl& impl)
+        {
+            return { get_type_id<zlazy_expression>(), reinterpret_cast<std::size_t>(&impl) };
+        }
 
         // this can be a  zreducer or something similar
         template <class E>
@@ -149,9 +193,13 @@ namespace xt
             }
 
             template <class E>
-            static std::tuple<const zarray_impl*, bool> get_array_impl(const E& e,  detail::zarray_temporary_pool & , const zassign_args&)
+            static std::tuple<const zarray_impl*, bool> get_array_impl(const E& e,  detail::zarray_temporary_pool & temporary_pool, const zassign_args& args)
             {
                 auto & impl = e.get_implementation();
+                if (!args.chunk_assign && is_inlined_lazy_operand(impl, temporary_pool))
+                {
+                    return impl.evaluate_lazy_expression(temporary_pool, args);
+                }
                 return std::make_tuple(&impl, false);
             }
         };
@@ -184,6 +232,786 @@ namespace xt
         {
             return zfunction_argument<E>::get_array_impl(e, temporary_pool, args);
         }
+
+        /*****************************
+         * temporary operand buffers *
+         *****************************/
+
+        // Operands held by value are temporaries owned by the zfunction.
+        // When the zfunction is itself a temporary consumed by its
+        // evaluation, the buffers of such zarrays are adopted by the pool
+        // and reused for the result or an intermediate result. Operands of
+        // a zfunction that can be evaluated again are never overwritten.
+        // CT is the closure type of the operand.
+        template <class CT>
+        struct zoperand_adopter
+        {
+            template <class E>
+            static void run(E&, zarray_temporary_pool&)
+            {
+            }
+        };
+
+        template <>
+        struct zoperand_adopter<zarray>
+        {
+            template <class E>
+            static void run(E& e, zarray_temporary_pool& temporary_pool)
+            {
+                zarray_impl& impl = e.get_implementation();
+                if (impl.owns_buffer() && impl.shape() == temporary_pool.shape())
+                {
+                    temporary_pool.adopt(impl);
+                }
+            }
+        };
+
+        template <class F, class... CT>
+        struct zoperand_adopter<zfunction<F, CT...>>
+        {
+            using argument_type = zfunction<F, CT...>;
+
+            static void run(argument_type& e, zarray_temporary_pool& temporary_pool)
+            {
+                run_impl(e, temporary_pool, std::make_index_sequence<sizeof...(CT)>());
+            }
+
+        private:
+
+            template <std::size_t... I>
+            static void run_impl(argument_type& e, zarray_temporary_pool& temporary_pool, std::index_sequence<I...>)
+            {
+                int dummy[] = {0, (zoperand_adopter<CT>::run(std::get<I>(e.arguments()), temporary_pool), 0)...};
+                (void)dummy;
+            }
+        };
+
+        template <class E>
+        inline void adopt_temporary_operands(E& e, zarray_temporary_pool& temporary_pool)
+        {
+            zoperand_adopter<E>::run(e, temporary_pool);
+        }
+
+        // Evaluates e in res; e is a temporary whose operands
+        // can be overwritten. Overloaded for zfunction.
+        template <class E>
+        inline void consume_to(E& e, zarray_impl& res, const zassign_args& args)
+        {
+            e.assign_to(res, args);
+        }
+
+        template <class F, class... CT>
+        inline void consume_to(zfunction<F, CT...>& e, zarray_impl& res, const zassign_args& args)
+        {
+            e.consume_to(res, args);
+        }
+
+        // Only adopted operands are reusable buffers
+        template <class CT>
+        struct zfunction_operand
+        {
+            template <class E>
+            static std::tuple<const zarray_impl*, bool> get_array_impl(const E& e, detail::zarray_temporary_pool & temporary_pool, const zassign_args& args)
+            {
+                return detail::get_array_impl(e, temporary_pool, args);
+            }
+        };
+
+        template <>
+        struct zfunction_operand<zarray>
+        {
+            template <class E>
+            static std::tuple<const zarray_impl*, bool> get_array_impl(const E& e, detail::zarray_temporary_pool & temporary_pool, const zassign_args& args)
+            {
+                const zarray_impl& impl = e.get_implementation();
+                if (!args.chunk_assign && is_inlined_lazy_operand(impl, temporary_pool))
+                {
+                    return impl.evaluate_lazy_expression(temporary_pool, args);
+                }
+                return std::make_tuple(&impl, temporary_pool.is_adopted(&impl));
+            }
+        };
+
+        template <class F, class... CT>
+        struct zchunk_input_key_builder<zfunction<F, CT...>>
+        {
+            using argument_type = zfunction<F, CT...>;
+
+            static bool run(const argument_type& e, const zarray_impl& res, std::size_t index, std::vector<std::size_t>& key)
+            {
+                key.push_back(get_type_id<F>());
+                key.push_back(sizeof...(CT));
+                auto func = [&res, index, &key](bool b, const auto& arg)
+                {
+                    using arg_type = std::decay_t<decltype(arg)>;
+                    return b && zchunk_input_key_builder<arg_type>::run(arg, res, index, key);
+                };
+                return accumulate(func, true, e.arguments());
+            }
+        };
+
+        template <class F, class... CT>
+        struct zchunked_operand_finder<zfunction<F, CT...>>
+        {
+            using argument_type = zfunction<F, CT...>;
+
+            static const zchunked_array* run(const argument_type& e, const dynamic_shape<std::size_t>& shape)
+            {
+                auto func = [&shape](const zchunked_array* res, const auto& arg)
+                {
+                    using arg_type = std::decay_t<decltype(arg)>;
+                    return res != nullptr ? res : zchunked_operand_finder<arg_type>::run(arg, shape);
+                };
+                return accumulate(func, static_cast<const zchunked_array*>(nullptr), e.arguments());
+            }
+        };
+
+        template <class F, class... CT>
+        struct zinplace_operand_checker<zfunction<F, CT...>>
+        {
+            using argument_type = zfunction<F, CT...>;
+
+            static bool run(const argument_type& e, const zarray_impl& res)
+            {
+                auto func = [&res](bool b, const auto& arg)
+                {
+                    using arg_type = std::decay_t<decltype(arg)>;
+                    return b && zinplace_operand_checker<arg_type>::run(arg, res);
+                };
+                return accumulate(func, true, e.arguments());
+            }
+        };
+
+        // Scalars are identified by their type and the bits of their value
+        template <class T>
+        inline void append_scalar_key(const T& value, std::vector<std::size_t>& key)
+        {
+            constexpr std::size_t word_count = (sizeof(T) + sizeof(std::size_t) - 1) / sizeof(std::size_t);
+            std::size_t words[word_count] = {};
+            std::memcpy(words, &value, sizeof(T));
+            key.push_back(get_type_id<T>());
+            key.insert(key.end(), words, words + word_count);
+        }
+
+        template <class CTE>
+        struct zchunk_input_key_builder<zscalar_wrapper<CTE>>
+        {
+            using argument_type = zscalar_wrapper<CTE>;
+
+            static bool run(const argument_type& e, const zarray_impl&, std::size_t, std::vector<std::size_t>& key)
+            {
+                append_scalar_key(*(e.scalar_value()), key);
+                return true;
+            }
+        };
+
+        /*********************************
+         * common subexpression analysis *
+         *********************************/
+
+        // Computes a key identifying the expression e: its functors, its
+        // structure, the addresses and versions of its zarray operands and
+        // the values of its scalars. Returns false when e cannot be identified.
+        // Specialized for zarray, zfunction and scalars.
+        template <class E>
+        struct zsubexpression_key_builder
+        {
+            static bool run(const E&, std::vector<std::size_t>&)
+            {
+                return false;
+            }
+        };
+
+        template <class F, class... CT>
+        struct zsubexpression_key_builder<zfunction<F, CT...>>
+        {
+            using argument_type = zfunction<F, CT...>;
+
+            static bool run(const argument_type& e, std::vector<std::size_t>& key)
+            {
+                key.push_back(get_type_id<F>());
+                key.push_back(sizeof...(CT));
+                auto func = [&key](bool b, const auto& arg)
+                {
+                    using arg_type = std::decay_t<decltype(arg)>;
+                    return b && zsubexpression_key_builder<arg_type>::run(arg, key);
+                };
+                return accumulate(func, true, e.arguments());
+            }
+        };
+
+        template <class CTE>
+        struct zsubexpression_key_builder<zscalar_wrapper<CTE>>
+        {
+            using argument_type = zscalar_wrapper<CTE>;
+
+            static bool run(const argument_type& e, std::vector<std::size_t>& key)
+            {
+                append_scalar_key(*(e.scalar_value()), key);
+                return true;
+            }
+        };
+
+        // Identical subexpressions have the same type: a tree whose
+        // zfunction types are all different has none, this is known
+        // at compile time.
+        template <class... T>
+        struct zfunction_node_list
+        {
+        };
+
+        template <class... L>
+        struct zconcat_node_lists;
+
+        template <>
+        struct zconcat_node_lists<>
+        {
+            using type = zfunction_node_list<>;
+        };
+
+        template <class... T>
+        struct zconcat_node_lists<zfunction_node_list<T...>>
+        {
+            using type = zfunction_node_list<T...>;
+        };
+
+        template <class... T, class... U, class... L>
+        struct zconcat_node_lists<zfunction_node_list<T...>, zfunction_node_list<U...>, L...>
+            : zconcat_node_lists<zfunction_node_list<T..., U...>, L...>
+        {
+        };
+
+        template <class E>
+        struct zfunction_nodes
+        {
+            using type = zfunction_node_list<>;
+        };
+
+        template <class F, class... CT>
+        struct zfunction_nodes<zfunction<F, CT...>>
+        {
+            using type = typename zconcat_node_lists<zfunction_node_list<zfunction<F, CT...>>,
+                                                     typename zfunction_nodes<std::decay_t<CT>>::type...>::type;
+        };
+
+        template <class L>
+        struct zhas_repeated_node;
+
+        template <>
+        struct zhas_repeated_node<zfunction_node_list<>> : std::false_type
+        {
+        };
+
+        template <class T, class... U>
+        struct zhas_repeated_node<zfunction_node_list<T, U...>>
+            : xtl::disjunction<std::is_same<T, U>..., zhas_repeated_node<zfunction_node_list<U...>>>
+        {
+        };
+
+        template <class E>
+        struct zsubexpression_counter
+        {
+            static void run(const E&, zarray_temporary_pool&)
+            {
+            }
+        };
+
+        template <class F, class... CT>
+        struct zsubexpression_counter<zfunction<F, CT...>>
+        {
+            using argument_type = zfunction<F, CT...>;
+
+            static void run(const argument_type& e, zarray_temporary_pool& temporary_pool)
+            {
+                std::vector<std::size_t> key;
+                if (zsubexpression_key_builder<argument_type>::run(e, key))
+                {
+                    temporary_pool.count_subexpression(key);
+                }
+                auto func = [&temporary_pool](bool b, const auto& arg)
+                {
+                    using arg_type = std::decay_t<decltype(arg)>;
+                    zsubexpression_counter<arg_type>::run(arg, temporary_pool);
+                    return b;
+                };
+                accumulate(func, true, e.arguments());
+            }
+        };
+
+        // Returns true when an operand of e is an unevaluated
+        // lazy zarray. Specialized for zarray and zfunction.
+        template <class E>
+        struct zlazy_operand_checker
+        {
+            static bool run(const E&)
+            {
+                return false;
+            }
+        };
+
+        template <class F, class... CT>
+        struct zlazy_operand_checker<zfunction<F, CT...>>
+        {
+            static bool run(const zfunction<F, CT...>& e)
+            {
+                auto func = [](bool b, const auto& arg)
+                {
+                    using arg_type = std::decay_t<decltype(arg)>;
+                    return b || zlazy_operand_checker<arg_type>::run(arg);
+                };
+                return accumulate(func, false, e.arguments());
+            }
+        };
+
+        // Lazy operands may hold repeated nodes, they
+        // are only known when the expression is evaluated
+        template <class E>
+        inline void count_subexpressions_impl(const E& e, zarray_temporary_pool& temporary_pool, std::false_type)
+        {
+            if (zlazy_operand_checker<E>::run(e))
+            {
+                zsubexpression_counter<E>::run(e, temporary_pool);
+            }
+        }
+
+        template <class E>
+        inline void count_subexpressions_impl(const E& e, zarray_temporary_pool& temporary_pool, std::true_type)
+        {
+            zsubexpression_counter<E>::run(e, temporary_pool);
+        }
+
+        // Registers the subexpressions of e in the pool before its
+        // evaluation, so that common ones are evaluated only once
+        template <class E>
+        inline void count_subexpressions(const E& e, zarray_temporary_pool& temporary_pool)
+        {
+            using has_repeated_node = zhas_repeated_node<typename zfunction_nodes<E>::type>;
+            count_subexpressions_impl(e, temporary_pool, std::integral_constant<bool, has_repeated_node::value>());
+        }
+
+        /*************************
+         * result buffer helpers *
+         *************************/
+
+        // The output of an operation: the result buffer of the pool is
+        // preferred, as an input buffer or if it is free, to avoid a final
+        // copy. Then an input buffer of the same type is reused, the other
+        // input buffers are marked as free.
+        template <std::size_t N>
+        inline zarray_impl* get_result_buffer(zarray_temporary_pool& temporary_pool,
+                                              const std::array<std::tuple<const zarray_impl*, bool>, N>& inputs,
+                                              std::size_t result_index)
+        {
+            zarray_impl * result_ptr = nullptr;
+            for(std::size_t i=0; i<N; ++i)
+            {
+                const auto impl_ptr = std::get<0>(inputs[i]);
+                if(std::get<1>(inputs[i]) && temporary_pool.is_result(impl_ptr) && result_index == impl_ptr->get_class_index())
+                {
+                    result_ptr = temporary_pool.get_writable(impl_ptr);
+                }
+            }
+            if(result_ptr == nullptr)
+            {
+                result_ptr = temporary_pool.get_free_result_buffer(result_index);
+            }
+
+            // reuse / free  buffers of the arguments
+            for(std::size_t i=0; i<N; ++i)
+            {
+                const auto is_buffer = std::get<1>(inputs[i]);
+                const auto impl_ptr = std::get<0>(inputs[i]);
+                // only consider buffers
+                if(is_buffer && impl_ptr != result_ptr)
+                {
+                    if(result_ptr==nullptr && result_index == impl_ptr->get_class_index())
+                    {
+                        result_ptr = temporary_pool.get_writable(impl_ptr);
+                    }
+                    else
+                    {
+                        temporary_pool.mark_as_free(impl_ptr);
+                    }
+                }
+            }
+
+            // in case we did not find a matching temporary
+            if(result_ptr == nullptr)
+            {
+                result_ptr = temporary_pool.get_free_buffer(result_index);
+            }
+            return result_ptr;
+        }
+
+        /***************************
+         * scalar operand rewrites *
+         ***************************/
+
+        // Scalar values for which an operation returns its other operand
+        template <class F>
+        struct zscalar_identity
+        {
+            template <class T>
+            static bool left(const T&)
+            {
+                return false;
+            }
+
+            template <class T>
+            static bool right(const T&)
+            {
+                return false;
+            }
+        };
+
+        // x + 0 is not exact for floating point values, -0 + 0 is +0
+        template <>
+        struct zscalar_identity<detail::plus>
+        {
+            template <class T>
+            static bool left(const T& value)
+            {
+                return (std::is_integral<T>::value || ZARRAY_FAST_MATH) && value == T(0);
+            }
+
+            template <class T>
+            static bool right(const T& value)
+            {
+                return left(value);
+            }
+        };
+
+        template <>
+        struct zscalar_identity<detail::minus>
+        {
+            template <class T>
+            static bool left(const T&)
+            {
+                return false;
+            }
+
+            template <class T>
+            static bool right(const T& value)
+            {
+                return value == T(0);
+            }
+        };
+
+        template <>
+        struct zscalar_identity<detail::multiplies>
+        {
+            template <class T>
+            static bool left(const T& value)
+            {
+                return value == T(1);
+            }
+
+            template <class T>
+            static bool right(const T& value)
+            {
+                return value == T(1);
+            }
+        };
+
+        template <>
+        struct zscalar_identity<detail::divides>
+        {
+            template <class T>
+            static bool left(const T&)
+            {
+                return false;
+            }
+
+            template <class T>
+            static bool right(const T& value)
+            {
+                return value == T(1);
+            }
+        };
+
+        // Associative and commutative operations, scalar chains
+        // of such operations can be folded into a single scalar
+        template <class F>
+        struct zassociative : std::false_type
+        {
+        };
+
+        template <>
+        struct zassociative<detail::plus> : std::true_type
+        {
+        };
+
+        template <>
+        struct zassociative<detail::multiplies> : std::true_type
+        {
+        };
+
+        // Reassociation is exact for integers only
+        template <class T>
+        struct zreassociable
+            : std::integral_constant<bool, (std::is_integral<T>::value && !std::is_same<T, bool>::value) ||
+                                           (std::is_floating_point<T>::value && ZARRAY_FAST_MATH)>
+        {
+        };
+
+        // Operation F between an operand and a scalar
+        template <class F, class E>
+        struct zscalar_chain : std::false_type
+        {
+            using value_type = void;
+        };
+
+        template <class F, class CT, class CTS>
+        struct zscalar_chain<F, zfunction<F, CT, zscalar_wrapper<CTS>>> : std::true_type
+        {
+            using argument_type = zfunction<F, CT, zscalar_wrapper<CTS>>;
+            using operand_type = std::decay_t<CT>;
+            using value_type = typename zscalar_wrapper<CTS>::value_type;
+
+            static const operand_type& operand(const argument_type& e)
+            {
+                return std::get<0>(e.arguments());
+            }
+
+            static const value_type& scalar(const argument_type& e)
+            {
+                return *(std::get<1>(e.arguments()).scalar_value());
+            }
+        };
+
+        template <class F, class CTS, class CT>
+        struct zscalar_chain<F, zfunction<F, zscalar_wrapper<CTS>, CT>> : std::true_type
+        {
+            using argument_type = zfunction<F, zscalar_wrapper<CTS>, CT>;
+            using operand_type = std::decay_t<CT>;
+            using value_type = typename zscalar_wrapper<CTS>::value_type;
+
+            static const operand_type& operand(const argument_type& e)
+            {
+                return std::get<1>(e.arguments());
+            }
+
+            static const value_type& scalar(const argument_type& e)
+            {
+                return *(std::get<0>(e.arguments()).scalar_value());
+            }
+        };
+
+        template <class F, class CTS1, class CTS2>
+        struct zscalar_chain<F, zfunction<F, zscalar_wrapper<CTS1>, zscalar_wrapper<CTS2>>> : std::false_type
+        {
+            using value_type = void;
+        };
+
+        template <class F, class E, class T>
+        using zfoldable_chain = std::integral_constant<bool, zassociative<F>::value &&
+                                                             zscalar_chain<F, E>::value &&
+                                                             std::is_same<typename zscalar_chain<F, E>::value_type, T>::value &&
+                                                             zreassociable<T>::value>;
+
+        // Evaluates F(e, value) with a single kernel, returns nullptr
+        // if its result type is not the expected one
+        template <class F, class E, class T>
+        inline zarray_impl* apply_scalar_operation(const E& e, const T& value, std::size_t result_index,
+                                                   zarray_temporary_pool& temporary_pool, const zassign_args& args)
+        {
+            using dispatcher_type = zdispatcher_t<F, 2>;
+            zscalar_wrapper<xscalar<T>> scalar = zscalar_wrapper<xscalar<T>>(xscalar<T>(value));
+            const zarray_impl& prototype = zarray_impl_register::get(get_result_type_index(e));
+            if (dispatcher_type::get_type_index(prototype, scalar) != result_index)
+            {
+                return nullptr;
+            }
+
+            std::array<std::tuple<const zarray_impl*, bool>, 1> inputs = { get_array_impl(e, temporary_pool, args) };
+            zarray_impl* result_ptr = get_result_buffer(temporary_pool, inputs, result_index);
+            dispatcher_type::dispatch(*std::get<0>(inputs[0]), scalar, *result_ptr, args);
+            return result_ptr;
+        }
+
+        template <class F, class E, class T>
+        inline zarray_impl* fold_scalar_chain(const E&, const T&, std::size_t,
+                                              zarray_temporary_pool&, const zassign_args&, std::false_type)
+        {
+            return nullptr;
+        }
+
+        // (e F s1) F s2 is evaluated as e F (s1 F s2)
+        template <class F, class E, class T>
+        inline zarray_impl* fold_scalar_chain(const E& e, const T& value, std::size_t result_index,
+                                              zarray_temporary_pool& temporary_pool, const zassign_args& args, std::true_type)
+        {
+            using chain = zscalar_chain<F, E>;
+            using operand_type = typename chain::operand_type;
+            // Folding s1 F s2 in T is only exact when T is the result
+            // type, e.g. two uint8_t scalars added to a promoted operand
+            if (get_result_type_index(e) != result_index ||
+                ztyped_array<T>::get_class_static_index() != result_index)
+            {
+                return nullptr;
+            }
+
+            T folded = static_cast<T>(F()(chain::scalar(e), value));
+            const operand_type& operand = chain::operand(e);
+            zarray_impl* res = fold_scalar_chain<F>(operand, folded, result_index, temporary_pool, args,
+                                                    zfoldable_chain<F, operand_type, T>());
+            return res != nullptr ? res : apply_scalar_operation<F>(operand, folded, result_index, temporary_pool, args);
+        }
+
+        // An operation with an identity scalar forwards the result of its
+        // other operand when it is a temporary buffer of the same type
+        template <class E>
+        inline zarray_impl* forward_operand(const E&, std::size_t, zarray_temporary_pool&, const zassign_args&)
+        {
+            return nullptr;
+        }
+
+        template <class F, class... CT>
+        inline zarray_impl* forward_operand(const zfunction<F, CT...>& e, std::size_t result_index,
+                                            zarray_temporary_pool& temporary_pool, const zassign_args& args)
+        {
+            return e.get_result_type_index() == result_index ? &(e.assign_to(temporary_pool, args)) : nullptr;
+        }
+
+        template <class F, class E, class T>
+        inline zarray_impl* simplify_scalar_operation(const E& e, const T& value, bool identity, std::size_t result_index,
+                                                      zarray_temporary_pool& temporary_pool, const zassign_args& args)
+        {
+            // shared buffers of common subexpressions must be released
+            // by each of their consumers, the rewrites do not track them
+            if (temporary_pool.has_common_subexpressions())
+            {
+                return nullptr;
+            }
+            zarray_impl* res = identity ? forward_operand(e, result_index, temporary_pool, args) : nullptr;
+            if (res == nullptr)
+            {
+                res = fold_scalar_chain<F>(e, value, result_index, temporary_pool, args, zfoldable_chain<F, E, T>());
+            }
+            return res;
+        }
+
+        // Rewrites a zfunction with a scalar operand before its evaluation:
+        // identity operations are dropped and scalar chains are folded.
+        // Returns nullptr if the zfunction must be evaluated as is.
+        template <class E>
+        struct zscalar_simplifier
+        {
+            static zarray_impl* run(const E&, zarray_temporary_pool&, const zassign_args&)
+            {
+                return nullptr;
+            }
+        };
+
+        template <class F, class CT, class CTS>
+        struct zscalar_simplifier<zfunction<F, CT, zscalar_wrapper<CTS>>>
+        {
+            using argument_type = zfunction<F, CT, zscalar_wrapper<CTS>>;
+
+            static zarray_impl* run(const argument_type& e, zarray_temporary_pool& temporary_pool, const zassign_args& args)
+            {
+                const auto& value = *(std::get<1>(e.arguments()).scalar_value());
+                return simplify_scalar_operation<F>(std::get<0>(e.arguments()), value, zscalar_identity<F>::right(value),
+                                                    e.get_result_type_index(), temporary_pool, args);
+            }
+        };
+
+        template <class F, class CTS, class CT>
+        struct zscalar_simplifier<zfunction<F, zscalar_wrapper<CTS>, CT>>
+        {
+            using argument_type = zfunction<F, zscalar_wrapper<CTS>, CT>;
+
+            static zarray_impl* run(const argument_type& e, zarray_temporary_pool& temporary_pool, const zassign_args& args)
+            {
+                const auto& value = *(std::get<0>(e.arguments()).scalar_value());
+                return simplify_scalar_operation<F>(std::get<1>(e.arguments()), value, zscalar_identity<F>::left(value),
+                                                    e.get_result_type_index(), temporary_pool, args);
+            }
+        };
+
+        template <class F, class CTS1, class CTS2>
+        struct zscalar_simplifier<zfunction<F, zscalar_wrapper<CTS1>, zscalar_wrapper<CTS2>>>
+        {
+            using argument_type = zfunction<F, zscalar_wrapper<CTS1>, zscalar_wrapper<CTS2>>;
+
+            static zarray_impl* run(const argument_type&, zarray_temporary_pool&, const zassign_args&)
+            {
+                return nullptr;
+            }
+        };
+
+        /********************
+         * fused operations *
+         ********************/
+
+        // a * b + c is evaluated by the fma kernel when its operands
+        // have the same floating point type: this saves the temporary
+        // holding a * b and a pass over memory
+        template <class FMA, class E, class C>
+        inline zarray_impl* fuse_multiply_add(const E&, const C&, std::size_t,
+                                              zarray_temporary_pool&, const zassign_args&)
+        {
+            return nullptr;
+        }
+
+        template <class FMA, class CT1, class CT2, class C>
+        inline zarray_impl* fuse_multiply_add(const zfunction<detail::multiplies, CT1, CT2>& e, const C& c, std::size_t result_index,
+                                              zarray_temporary_pool& temporary_pool, const zassign_args& args)
+        {
+            if (!ZARRAY_FP_CONTRACT || temporary_pool.has_common_subexpressions())
+            {
+                return nullptr;
+            }
+
+            const auto& a = std::get<0>(e.arguments());
+            const auto& b = std::get<1>(e.arguments());
+            const bool is_floating_point = result_index == ztyped_array<double>::get_class_static_index() ||
+                                           result_index == ztyped_array<float>::get_class_static_index();
+            if (!is_floating_point ||
+                get_result_type_index(a) != result_index ||
+                get_result_type_index(b) != result_index ||
+                get_result_type_index(c) != result_index)
+            {
+                return nullptr;
+            }
+
+            std::array<std::tuple<const zarray_impl*, bool>, 3> inputs = {
+                get_array_impl(a, temporary_pool, args),
+                get_array_impl(b, temporary_pool, args),
+                get_array_impl(c, temporary_pool, args)
+            };
+            zarray_impl* result_ptr = get_result_buffer(temporary_pool, inputs, result_index);
+            zdispatcher_t<FMA, 3>::dispatch(*std::get<0>(inputs[0]),
+                                            *std::get<0>(inputs[1]),
+                                            *std::get<0>(inputs[2]),
+                                            *result_ptr, args);
+            return result_ptr;
+        }
+
+        // Evaluates a zfunction with a fused kernel matching its pattern,
+        // returns nullptr if there is none
+        template <class E>
+        struct zfused_operation
+        {
+            static zarray_impl* run(const E&, zarray_temporary_pool&, const zassign_args&)
+            {
+                return nullptr;
+            }
+        };
+
+        template <class CT1, class CT2>
+        struct zfused_operation<zfunction<detail::plus, CT1, CT2>>
+        {
+            using argument_type = zfunction<detail::plus, CT1, CT2>;
+
+            static zarray_impl* run(const argument_type& e, zarray_temporary_pool& temporary_pool, const zassign_args& args)
+            {
+                const auto& lhs = std::get<0>(e.arguments());
+                const auto& rhs = std::get<1>(e.arguments());
+                zarray_impl* res = fuse_multiply_add<math::fma_fun>(lhs, rhs, e.get_result_type_index(), temporary_pool, args);
+                return res != nullptr ? res : fuse_multiply_add<math::fma_fun>(rhs, lhs, e.get_result_type_index(), temporary_pool, args);
+            }
+        };
     }
 
     template <class F, class... CT>
@@ -230,10 +1058,29 @@ namespace xt
         }
     }
     
+    template <class F, class... CT>
+    inline auto zfunction<F, CT...>::arguments() const -> const tuple_type&
+    {
+        return m_e;
+    }
+
+    template <class F, class... CT>
+    inline auto zfunction<F, CT...>::arguments() -> tuple_type&
+    {
+        return m_e;
+    }
+
+    // The result is chunked like the first chunked operand
+    // with the shape of the result
     template <class F, class... CT>
     inline std::unique_ptr<zarray_impl> zfunction<F, CT...>::allocate_result() const
     {
         std::size_t idx = get_result_type_index();
+        const zchunked_array* operand = detail::zchunked_operand_finder<zfunction>::run(*this, shape());
+        if (operand != nullptr)
+        {
+            return std::unique_ptr<zarray_impl>(zarray_impl_register::make_chunked(idx, shape(), operand->chunk_shape()));
+        }
         return std::unique_ptr<zarray_impl>(zarray_impl_register::get(idx).clone());
     }
 
@@ -247,6 +1094,27 @@ namespace xt
     inline zarray_impl& zfunction<F, CT...>::assign_to(zarray_impl& res, const zassign_args& args) const
     {
         detail::zarray_temporary_pool  temporary_pool(res);
+        return assign_result(temporary_pool, res, args);
+    }
+
+    // Evaluates the zfunction in res, overwriting the buffers of its
+    // temporary zarray operands: it must not be evaluated again.
+    // Chunk by chunk evaluations keep the operands intact.
+    template <class F, class... CT>
+    inline zarray_impl& zfunction<F, CT...>::consume_to(zarray_impl& res, const zassign_args& args)
+    {
+        detail::zarray_temporary_pool  temporary_pool(res);
+        if (!args.chunk_assign && !res.is_chunked())
+        {
+            detail::adopt_temporary_operands(*this, temporary_pool);
+        }
+        return assign_result(temporary_pool, res, args);
+    }
+
+    template <class F, class... CT>
+    inline zarray_impl& zfunction<F, CT...>::assign_result(detail::zarray_temporary_pool & temporary_pool, zarray_impl& res, const zassign_args& args) const
+    {
+        detail::count_subexpressions(*this, temporary_pool);
         auto & r = this->assign_to(temporary_pool, args);
         if(&r != &res)
         {
@@ -278,7 +1146,32 @@ namespace xt
     template <class F, class... CT>
     inline zarray_impl& zfunction<F, CT...>::assign_to(detail::zarray_temporary_pool & buffer, const zassign_args& args) const
     {
-        return assign_to_impl(std::make_index_sequence<sizeof...(CT)>(), buffer, args);
+        if (buffer.has_common_subexpressions())
+        {
+            std::vector<std::size_t> key;
+            if (detail::zsubexpression_key_builder<self_type>::run(*this, key) && buffer.is_common_subexpression(key))
+            {
+                zarray_impl* res = buffer.get_common_result(key);
+                if (res == nullptr)
+                {
+                    res = &evaluate(buffer, args);
+                    buffer.set_common_result(key, res);
+                }
+                return *res;
+            }
+        }
+        return evaluate(buffer, args);
+    }
+
+    template <class F, class... CT>
+    inline zarray_impl& zfunction<F, CT...>::evaluate(detail::zarray_temporary_pool & temporary_pool, const zassign_args& args) const
+    {
+        zarray_impl* res = detail::zscalar_simplifier<self_type>::run(*this, temporary_pool, args);
+        if (res == nullptr)
+        {
+            res = detail::zfused_operation<self_type>::run(*this, temporary_pool, args);
+        }
+        return res != nullptr ? *res : assign_to_impl(std::make_index_sequence<sizeof...(CT)>(), temporary_pool, args);
     }
 
 
@@ -313,37 +1206,20 @@ namespace xt
         // inputs
         constexpr std::size_t arity = sizeof...(CT);
         std::array< std::tuple<const zarray_impl *, bool>, arity> inputs = {
-            detail::get_array_impl(std::get<I>(m_e), temporary_pool, args) ...
+            detail::zfunction_operand<std::remove_cv_t<CT>>::get_array_impl(std::get<I>(m_e), temporary_pool, args) ...
         };
 
-        // the output
-        zarray_impl * result_ptr = nullptr;
-
-        // reuse / free  buffers of the arguments
+        // shared buffers of common subexpressions are released
+        // by their last consumer only
         for(std::size_t i=0; i<arity; ++i)
         {
-            const auto is_buffer = std::get<1>(inputs[i]);
-            const auto impl_ptr = std::get<0>(inputs[i]);
-            // only consider buffers
-            if(is_buffer)
-            {   
-                if(result_ptr==nullptr && m_result_type_index == impl_ptr->get_class_index())
-                {
-                    // get the same buffer as non-const!
-                    result_ptr = const_cast<zarray_impl *>(impl_ptr);
-                }
-                else 
-                {
-                    temporary_pool.mark_as_free(impl_ptr);
-                }
+            if(std::get<1>(inputs[i]))
+            {
+                std::get<1>(inputs[i]) = temporary_pool.consume(std::get<0>(inputs[i]));
             }
         }
 
-        // in case we did not find a matching temporary
-        if(result_ptr == nullptr)
-        {
-            result_ptr = temporary_pool.get_free_buffer(m_result_type_index);
-        }
+        zarray_impl * result_ptr = detail::get_result_buffer(temporary_pool, inputs, m_result_type_index);
 
         // call the operator dispatcher
         dispatcher_type::dispatch(
@@ -41,7 +41,7 @@ namespace xt
         {
             if (!args.chunk_assign)
                 zassign_wrapped_expression(zres, z.get_array(), args);
-            else
+            else if (!zassign_constant_chunk(detail::identity(), z, zres, args))
                 zassign_wrapped_expression(zres,  z.get_chunk(args.slices()), args);
         }
 
@@ -63,7 +63,7 @@ namespace xt
             zres.resize(z.shape());
             if (!args.chunk_assign)
                 zassign_wrapped_expression(zres, z.get_array(), args);
-            else
+            else if (!zassign_constant_chunk(detail::identity(), z, zres, args))
                 zassign_wrapped_expression(zres, z.get_chunk(args.slices()), args);
         }
 
@@ -78,7 +78,10 @@ namespace xt
             }
             else if (zres.is_chunked())
             {
-                zassign_wrapped_expression(zres, z.get_chunk(args.slices()), args);
+                if (!zassign_constant_chunk(detail::identity(), z, zres, args))
+                {
+                    zassign_wrapped_expression(zres, z.get_chunk(args.slices()), args);
+                }
             }
             else
             {
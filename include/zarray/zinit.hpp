@@ -13,6 +13,7 @@
 #include "xtensor/xmath.hpp"
 #include "xtensor/xnorm.hpp"
 
+#include "zarray_config.hpp"
 #include "zdispatcher.hpp"
 #include "zdispatching_types.hpp"
 #include "zmath.hpp"
@@ -33,6 +34,8 @@ namespace xt
     // static variable and be automatically
     // called when loading a shared library
     // for instance.
+    // Initialization is optional: a dispatcher
+    // is built on its first dispatch otherwise.
 
     int init_zsystem();
 
@@ -67,6 +70,7 @@ namespace xt
         zdispatcher_t<detail::logical_or, 2>::init();
         zdispatcher_t<detail::logical_and, 2>::init();
         zdispatcher_t<detail::logical_not, 1>::init();
+        zdispatcher_t<detail::conditional_ternary, 3>::init();
         return 0;
     }
 
@@ -107,6 +111,8 @@ namespace xt
         zdispatcher_t<math::fmax_fun, 2>::init();
         zdispatcher_t<math::fmin_fun, 2>::init();
         zdispatcher_t<math::fdim_fun, 2>::init();
+        zdispatcher_t<math::fma_fun, 3>::init();
+        zdispatcher_t<math::clamp_fun, 3>::init();
         return 0;
     }
 
@@ -254,14 +260,209 @@ namespace xt
         return 0;
     }
 
+    /******************************
+     * op families initialization *
+     ******************************/
+
+    namespace detail
+    {
+        // The dispatchers of a family are instantiated
+        // only if it is part of Families
+        template <unsigned int Families, unsigned int Family, class F>
+        inline void init_zop_family(F&& f)
+        {
+            xtl::mpl::static_if<(Families & Family) != 0u>(std::forward<F>(f), [](auto /*no_compile*/) {});
+        }
+    }
+
+    // Initializes the dispatchers of the op families selected by
+    // Families, a combination of the ZARRAY_*_OPS flags, e.g.
+    // init_zdispatchers<ZARRAY_ARITHMETIC_OPS | ZARRAY_REDUCER_OPS>()
+    template <unsigned int Families>
+    inline int init_zdispatchers()
+    {
+        detail::init_zop_family<Families, ZARRAY_REDUCER_OPS>([](auto t) { init_zreducer_dispatchers<decltype(t)>(); });
+
+        detail::init_zop_family<Families, ZARRAY_ASSIGN_OPS>([](auto t) { init_zassign_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_ARITHMETIC_OPS>([](auto t) { init_zarithmetic_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_LOGICAL_OPS>([](auto t) { init_zlogical_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_BITWISE_OPS>([](auto t) { init_zbitwise_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_COMPARISON_OPS>([](auto t) { init_zcomparison_dispatchers<decltype(t)>(); });
+
+        detail::init_zop_family<Families, ZARRAY_BASIC_MATH_OPS>([](auto t) { init_zbasic_math_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_EXP_OPS>([](auto t) { init_zexp_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_POWER_OPS>([](auto t) { init_zpower_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_TRIGONOMETRIC_OPS>([](auto t) { init_ztrigonometric_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_HYPERBOLIC_OPS>([](auto t) { init_zhyperbolic_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_ERF_OPS>([](auto t) { init_zerf_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_GAMMA_OPS>([](auto t) { init_zgamma_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_ROUNDING_OPS>([](auto t) { init_zrounding_dispatchers<decltype(t)>(); });
+        detail::init_zop_family<Families, ZARRAY_CLASSIFICATION_OPS>([](auto t) { init_zclassification_dispatchers<decltype(t)>(); });
+        return 0;
+    }
+
+    // Initializes the op families of ZARRAY_OP_FAMILIES
     template <class T = void>
     int init_zsystem()
     {
-        init_zreducer_dispatchers<T>();
-        init_zoperator_dispatchers<T>();
-        init_zmath_dispatchers<T>();
-        return 0;
+        return init_zdispatchers<ZARRAY_OP_FAMILIES>();
     }
+
+    /**********************************
+     * compiled library instantiation *
+     **********************************/
+
+    // The dispatchers of the ZARRAY_OP_FAMILIES are instantiated once
+    // in the compiled library, translation units using it only see
+    // extern template declarations and do not instantiate the kernels
+
+#if ZARRAY_COMPILED_LIBRARY
+
+#ifdef ZARRAY_LIBRARY_SOURCE
+#define ZARRAY_INSTANTIATE template
+#else
+#define ZARRAY_INSTANTIATE extern template
+#endif
+
+// zreducer_dispatcher cannot be explicitly instantiated through the alias
+#define ZARRAY_REDUCER_DISPATCHER(F)                                                                \
+    zdouble_dispatcher<F, mpl::vector<const zassign_args, const zreducer_options>, mpl::vector<const zreducer_options>>
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_ASSIGN_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<detail::xassign_dummy_functor>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<detail::xmove_dummy_functor>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_ARITHMETIC_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<detail::identity>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<detail::negate>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::plus>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::minus>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::multiplies>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::divides>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::modulus>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_LOGICAL_OPS
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::logical_or>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::logical_and>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<detail::logical_not>;
+    ZARRAY_INSTANTIATE class zquadruple_dispatcher<detail::conditional_ternary>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_BITWISE_OPS
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::bitwise_or>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::bitwise_and>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::bitwise_xor>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<detail::bitwise_not>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::left_shift>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::right_shift>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_COMPARISON_OPS
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::less>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::less_equal>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::greater>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::greater_equal>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::equal_to>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<detail::not_equal_to>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_BASIC_MATH_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::fabs_fun>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::fmod_fun>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::remainder_fun>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::fmax_fun>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::fmin_fun>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::fdim_fun>;
+    ZARRAY_INSTANTIATE class zquadruple_dispatcher<math::fma_fun>;
+    ZARRAY_INSTANTIATE class zquadruple_dispatcher<math::clamp_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_EXP_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::exp_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::exp2_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::expm1_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::log_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::log10_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::log2_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::log1p_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_POWER_OPS
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::pow_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::sqrt_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::cbrt_fun>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::hypot_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_TRIGONOMETRIC_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::sin_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::cos_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::tan_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::asin_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::acos_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::atan_fun>;
+    ZARRAY_INSTANTIATE class ztriple_dispatcher<math::atan2_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_HYPERBOLIC_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::sinh_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::cosh_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::tanh_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::asinh_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::acosh_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::atanh_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_ERF_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::erf_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::erfc_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_GAMMA_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::tgamma_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::lgamma_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_ROUNDING_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::ceil_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::floor_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::trunc_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::round_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::nearbyint_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::rint_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_CLASSIFICATION_OPS
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::isfinite_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::isinf_fun>;
+    ZARRAY_INSTANTIATE class zdouble_dispatcher<math::isnan_fun>;
+#endif
+
+#if ZARRAY_OP_FAMILIES & ZARRAY_REDUCER_OPS
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zassign_init_value_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zsum_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zprod_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zmean_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zvariance_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zstddev_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zamin_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(zamax_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_l0_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_l1_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_l2_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_sq_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_linf_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_lp_to_p_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_induced_l1_zreducer_functor);
+    ZARRAY_INSTANTIATE class ZARRAY_REDUCER_DISPATCHER(znorm_induced_linf_zreducer_functor);
+#endif
+
+#undef ZARRAY_REDUCER_DISPATCHER
+#undef ZARRAY_INSTANTIATE
+
+#endif
 }
 
 #endif
@@ -0,0 +1,351 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XTENSOR_ZLAZY_WRAPPER_HPP
+#define XTENSOR_ZLAZY_WRAPPER_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+#include "zarray_wrapper.hpp"
+#include "zexpression_wrapper.hpp"
+
+namespace xt
+{
+    /********************
+     * zlazy_expression *
+     ********************/
+
+    // Unevaluated zarray expression held by a lazy zarray. The
+    // operands of the expression are read when it is evaluated.
+    class zlazy_expression
+    {
+    public:
+
+        using shape_type = zarray_impl::shape_type;
+
+        virtual ~zlazy_expression() = default;
+
+        zlazy_expression(zlazy_expression&&) = delete;
+        zlazy_expression& operator=(const zlazy_expression&) = delete;
+        zlazy_expression& operator=(zlazy_expression&&) = delete;
+
+        virtual zlazy_expression* clone() const = 0;
+
+        virtual std::size_t dimension() const = 0;
+        virtual const shape_type& shape() const = 0;
+        virtual bool broadcast_shape(shape_type& shape, bool reuse_cache = false) const = 0;
+
+        // Resizes res and evaluates the expression in it
+        virtual void assign_to(zarray_impl& res) const = 0;
+
+        // Resizes res and evaluates the expression in it, with the
+        // temporaries and common subexpressions of the pool of an
+        // expression it is an operand of. Returns the buffer holding
+        // the result in the pool.
+        virtual std::tuple<const zarray_impl*, bool> assign_to(zarray_impl& res,
+                                                               detail::zarray_temporary_pool& temporary_pool,
+                                                               const zassign_args& args) const = 0;
+        virtual void count_subexpressions(detail::zarray_temporary_pool& temporary_pool) const = 0;
+
+    protected:
+
+        zlazy_expression() = default;
+        zlazy_expression(const zlazy_expression&) = default;
+    };
+
+    /*****************
+     * zlazy_wrapper *
+     *****************/
+
+    // The expression is evaluated once, in the array of the wrapper: on
+    // the first access to the data, or inlined in the evaluation of an
+    // expression using the wrapper. Const accesses may run concurrently,
+    // the first one evaluates the expression under a lock.
+    template <class T>
+    class zlazy_wrapper : public ztyped_expression_wrapper<T>
+    {
+    public:
+
+        using self_type = zlazy_wrapper<T>;
+        using value_type = T;
+        using base_type = ztyped_expression_wrapper<value_type>;
+        using shape_type = typename base_type::shape_type;
+        using slice_vector = typename base_type::slice_vector;
+
+        explicit zlazy_wrapper(zlazy_expression* e);
+
+        virtual ~zlazy_wrapper() = default;
+
+        bool is_array() const override;
+        bool is_chunked() const override;
+        bool owns_buffer() const override;
+
+        xarray<value_type>& get_array() override;
+        const xarray<value_type>& get_array() const override;
+        xarray<value_type> get_chunk(const slice_vector& slices) const override;
+
+        const zlazy_expression* get_lazy_expression() const override;
+        std::tuple<const zarray_impl*, bool>
+        evaluate_lazy_expression(detail::zarray_temporary_pool& temporary_pool, const zassign_args& args) const override;
+
+        void assign(xarray<value_type>&& rhs) override;
+
+        self_type* clone() const override;
+        std::ostream& print(std::ostream& out) const override;
+
+        zarray_impl* strided_view(slice_vector& slices) override;
+
+        const nlohmann::json& get_metadata() const override;
+        void set_metadata(const nlohmann::json& metadata) override;
+        std::size_t dimension() const override;
+        const shape_type& shape() const override;
+        void reshape(const shape_type&) override;
+        void reshape(shape_type&&) override;
+        void resize(const shape_type&) override;
+        void resize(shape_type&&) override;
+        bool broadcast_shape(shape_type& shape, bool reuse_cache = 0) const override;
+
+    private:
+
+        zlazy_wrapper(const zlazy_wrapper& rhs);
+
+        bool is_evaluated() const;
+        void evaluate_expression() const;
+        void drop_expression();
+
+        // The expression is kept until a non-const access, so that
+        // the shape can be read while it is evaluated
+        std::unique_ptr<zlazy_expression> p_expression;
+        mutable xarray<value_type> m_array;
+        mutable std::atomic<bool> m_evaluated;
+        mutable std::mutex m_mutex;
+        zmetadata<value_type> m_metadata;
+    };
+
+    /********************************
+     * zlazy_wrapper implementation *
+     ********************************/
+
+    template <class T>
+    inline zlazy_wrapper<T>::zlazy_wrapper(zlazy_expression* e)
+        : base_type()
+        , p_expression(e)
+        , m_array()
+        , m_evaluated(false)
+        , m_mutex()
+    {
+    }
+
+    template <class T>
+    inline zlazy_wrapper<T>::zlazy_wrapper(const zlazy_wrapper& rhs)
+        : base_type(rhs)
+        , p_expression()
+        , m_array()
+        , m_evaluated(false)
+        , m_mutex()
+        , m_metadata(rhs.m_metadata)
+    {
+        std::lock_guard<std::mutex> lock(rhs.m_mutex);
+        if (rhs.m_evaluated.load(std::memory_order_relaxed))
+        {
+            m_array = rhs.m_array;
+            m_evaluated.store(true, std::memory_order_relaxed);
+        }
+        else
+        {
+            p_expression.reset(rhs.p_expression->clone());
+        }
+    }
+
+    // Once evaluated, the wrapper is a dense array
+    template <class T>
+    bool zlazy_wrapper<T>::is_array() const
+    {
+        return is_evaluated();
+    }
+
+    template <class T>
+    bool zlazy_wrapper<T>::is_chunked() const
+    {
+        return false;
+    }
+
+    template <class T>
+    bool zlazy_wrapper<T>::owns_buffer() const
+    {
+        return false;
+    }
+
+    template <class T>
+    auto zlazy_wrapper<T>::get_array() -> xarray<value_type>&
+    {
+        this->update_version();
+        evaluate_expression();
+        return m_array;
+    }
+
+    template <class T>
+    auto zlazy_wrapper<T>::get_array() const -> const xarray<value_type>&
+    {
+        evaluate_expression();
+        return m_array;
+    }
+
+    template <class T>
+    auto zlazy_wrapper<T>::get_chunk(const slice_vector& slices) const -> xarray<value_type>
+    {
+        return xt::strided_view(get_array(), slices);
+    }
+
+    template <class T>
+    const zlazy_expression* zlazy_wrapper<T>::get_lazy_expression() const
+    {
+        return is_evaluated() ? nullptr : p_expression.get();
+    }
+
+    template <class T>
+    std::tuple<const zarray_impl*, bool>
+    zlazy_wrapper<T>::evaluate_lazy_expression(detail::zarray_temporary_pool& temporary_pool, const zassign_args& args) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_evaluated.load(std::memory_order_relaxed))
+        {
+            return std::make_tuple(this, false);
+        }
+        zarray_wrapper<xarray<value_type>&> res(m_array);
+        auto input = p_expression->assign_to(res, temporary_pool, args);
+        m_evaluated.store(true, std::memory_order_release);
+        return input;
+    }
+
+    template <class T>
+    void zlazy_wrapper<T>::assign(xarray<value_type>&& rhs)
+    {
+        this->update_version();
+        drop_expression();
+        m_array = std::move(rhs);
+    }
+
+    template <class T>
+    auto zlazy_wrapper<T>::clone() const -> self_type*
+    {
+        return new self_type(*this);
+    }
+
+    template <class T>
+    std::ostream& zlazy_wrapper<T>::print(std::ostream& out) const
+    {
+        return out << get_array();
+    }
+
+    template <class T>
+    zarray_impl* zlazy_wrapper<T>::strided_view(slice_vector& slices)
+    {
+        this->update_version();
+        auto e = xt::strided_view(get_array(), slices);
+        return detail::build_zarray(std::move(e));
+    }
+
+    template <class T>
+    auto zlazy_wrapper<T>::get_metadata() const -> const nlohmann::json&
+    {
+        return m_metadata.get();
+    }
+
+    template <class T>
+    void zlazy_wrapper<T>::set_metadata(const nlohmann::json& metadata)
+    {
+        m_metadata.set(metadata);
+    }
+
+    template <class T>
+    std::size_t zlazy_wrapper<T>::dimension() const
+    {
+        return is_evaluated() ? m_array.dimension() : p_expression->dimension();
+    }
+
+    template <class T>
+    auto zlazy_wrapper<T>::shape() const -> const shape_type&
+    {
+        return is_evaluated() ? m_array.shape() : p_expression->shape();
+    }
+
+    template <class T>
+    void zlazy_wrapper<T>::reshape(const shape_type& shape)
+    {
+        this->update_version();
+        get_array().reshape(shape);
+    }
+
+    template <class T>
+    void zlazy_wrapper<T>::reshape(shape_type&& shape)
+    {
+        this->update_version();
+        get_array().reshape(std::move(shape));
+    }
+
+    // The wrapper is resized before being assigned,
+    // the expression is dropped without evaluation
+    template <class T>
+    void zlazy_wrapper<T>::resize(const shape_type& shape)
+    {
+        this->update_version();
+        drop_expression();
+        m_array.resize(shape);
+    }
+
+    template <class T>
+    void zlazy_wrapper<T>::resize(shape_type&& shape)
+    {
+        this->update_version();
+        drop_expression();
+        m_array.resize(std::move(shape));
+    }
+
+    template <class T>
+    bool zlazy_wrapper<T>::broadcast_shape(shape_type& shape, bool reuse_cache) const
+    {
+        return is_evaluated() ? m_array.broadcast_shape(shape, reuse_cache)
+                              : p_expression->broadcast_shape(shape, reuse_cache);
+    }
+
+    template <class T>
+    inline bool zlazy_wrapper<T>::is_evaluated() const
+    {
+        return m_evaluated.load(std::memory_order_acquire);
+    }
+
+    template <class T>
+    inline void zlazy_wrapper<T>::evaluate_expression() const
+    {
+        if (!is_evaluated())
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_evaluated.load(std::memory_order_relaxed))
+            {
+                zarray_wrapper<xarray<value_type>&> res(m_array);
+                p_expression->assign_to(res);
+                m_evaluated.store(true, std::memory_order_release);
+            }
+        }
+    }
+
+    // The expression is not evaluated
+    template <class T>
+    inline void zlazy_wrapper<T>::drop_expression()
+    {
+        p_expression.reset();
+        m_evaluated.store(true, std::memory_order_release);
+    }
+}
+
+#endif
@@ -39,7 +39,7 @@ namespace xt
         {                                                                                          \
             if (!args.chunk_assign)                                                                \
                 zassign_wrapped_expression(zres, XOP z.get_array(), args);                         \
-            else                                                                                   \
+            else if (!zassign_constant_chunk(XFUN(), z, zres, args))                               \
                 zassign_wrapped_expression(zres, XOP z.get_chunk(args.slices()), args);            \
         }                                                                                          \
         template <class T>                                                                         \
@@ -51,6 +51,7 @@ namespace xt
     };                                                                                             \
     XTENSOR_ZMAPPED_FUNCTOR(ZNAME, XFUN)
 
+// Scalar operands are broadcast as values instead of 0-D arrays
 #define XTENSOR_BINARY_ZOPERATOR(ZNAME, XOP, XFUN)                                 \
     struct ZNAME                                                                   \
     {                                                                              \
@@ -60,14 +61,33 @@ namespace xt
                         ztyped_array<R>& zres,                                     \
                         const zassign_args& args)                                  \
         {                                                                          \
+            const T1* s1 = z1.scalar_value();                                      \
+            const T2* s2 = z2.scalar_value();                                      \
             if (!args.chunk_assign)                                                \
-                zassign_wrapped_expression(zres,                                   \
-                                           z1.get_array() XOP z2.get_array(),      \
-                                           args);                                  \
-            else                                                                   \
-                zassign_wrapped_expression(zres,                                   \
-                                           z1.get_chunk(args.slices()) XOP z2.get_chunk(args.slices()),      \
-                                           args);                                  \
+            {                                                                      \
+                if (zassign_broadcast(XFUN(), z1, z2, zres, args))                 \
+                    return;                                                        \
+                if (s2 != nullptr)                                                 \
+                    zassign_wrapped_expression(zres, z1.get_array() XOP *s2, args); \
+                else if (s1 != nullptr)                                            \
+                    zassign_wrapped_expression(zres, *s1 XOP z2.get_array(), args); \
+                else                                                               \
+                    zassign_wrapped_expression(zres,                               \
+                                               z1.get_array() XOP z2.get_array(),  \
+                                               args);                              \
+            }                                                                      \
+            else if (!zassign_constant_chunk(XFUN(), z1, z2, zres, args) &&        \
+                     !zassign_pruned_chunk(XFUN(), z1, z2, zres, args))            \
+            {                                                                      \
+                if (s2 != nullptr)                                                 \
+                    zassign_wrapped_expression(zres, z1.get_chunk(args.slices()) XOP *s2, args); \
+                else if (s1 != nullptr)                                            \
+                    zassign_wrapped_expression(zres, *s1 XOP z2.get_chunk(args.slices()), args); \
+                else                                                               \
+                    zassign_wrapped_expression(zres,                               \
+                                               z1.get_chunk(args.slices()) XOP z2.get_chunk(args.slices()),      \
+                                               args);                              \
+            }                                                                      \
         }                                                                          \
         template <class T1, class T2>                                              \
         static size_t index(const ztyped_array<T1>&, const ztyped_array<T2>&)      \
@@ -89,7 +109,7 @@ namespace xt
         {                                                                          \
             if (!args.chunk_assign )                                               \
                 zassign_wrapped_expression(zres, XEXP(z.get_array()), args);       \
-            else                                                                   \
+            else if (!zassign_constant_chunk(XFUN(), z, zres, args))               \
                 zassign_wrapped_expression(zres, XEXP(z.get_chunk(args.slices())), args); \
         }                                                                          \
         template <class T>                                                         \
@@ -111,10 +131,14 @@ namespace xt
                         const zassign_args& args)                                  \
         {                                                                          \
             if (!args.chunk_assign)                                                \
-                zassign_wrapped_expression(zres,                                   \
-                                           XEXP(z1.get_array(), z2.get_array()),   \
-                                           args);                                  \
-            else                                                                   \
+            {                                                                      \
+                if (!zassign_broadcast(XFUN(), z1, z2, zres, args))                \
+                    zassign_wrapped_expression(zres,                               \
+                                               XEXP(z1.get_array(), z2.get_array()), \
+                                               args);                              \
+            }                                                                      \
+            else if (!zassign_constant_chunk(XFUN(), z1, z2, zres, args) &&        \
+                     !zassign_pruned_chunk(XFUN(), z1, z2, zres, args))            \
                 zassign_wrapped_expression(zres,                                   \
                                            XEXP(z1.get_chunk(args.slices()), z2.get_chunk(args.slices())),   \
                                            args);                                  \
@@ -129,6 +153,43 @@ namespace xt
     };                                                                             \
     XTENSOR_ZMAPPED_FUNCTOR(ZNAME, XFUN)
 
+#define XTENSOR_TERNARY_ZFUNCTOR(ZNAME, XEXP, XFUN)                                \
+    struct ZNAME                                                                   \
+    {                                                                              \
+        template <class T1, class T2, class T3, class R>                           \
+        static void run(const ztyped_array<T1>& z1,                                \
+                        const ztyped_array<T2>& z2,                                \
+                        const ztyped_array<T3>& z3,                                \
+                        ztyped_array<R>& zres,                                     \
+                        const zassign_args& args)                                  \
+        {                                                                          \
+            if (!args.chunk_assign)                                                \
+                zassign_wrapped_expression(zres,                                   \
+                                           XEXP(z1.get_array(),                    \
+                                                z2.get_array(),                    \
+                                                z3.get_array()),                   \
+                                           args);                                  \
+            else if (!zassign_constant_chunk(XFUN(), z1, z2, z3, zres, args) &&    \
+                     !zassign_selected_chunk(XFUN(), z1, z2, z3, zres, args))      \
+                zassign_wrapped_expression(zres,                                   \
+                                           XEXP(z1.get_chunk(args.slices()),       \
+                                                z2.get_chunk(args.slices()),       \
+                                                z3.get_chunk(args.slices())),      \
+                                           args);                                  \
+        }                                                                          \
+        template <class T1, class T2, class T3>                                    \
+        static size_t index(const ztyped_array<T1>&,                               \
+                            const ztyped_array<T2>&,                               \
+                            const ztyped_array<T3>&)                               \
+        {                                                                          \
+            using value_type = decltype(std::declval<XFUN>()(std::declval<T1>(),   \
+                                                             std::declval<T2>(),   \
+                                                             std::declval<T3>())); \
+            return ztyped_array<value_type>::get_class_static_index();             \
+        }                                                                          \
+    };                                                                             \
+    XTENSOR_ZMAPPED_FUNCTOR(ZNAME, XFUN)
+
     XTENSOR_UNARY_ZOPERATOR(zidentity, +, detail::identity);
     XTENSOR_UNARY_ZOPERATOR(znegate, -, detail::negate);
     XTENSOR_BINARY_ZOPERATOR(zplus, +, detail::plus);
@@ -156,7 +217,9 @@ namespace xt
     XTENSOR_UNARY_ZFUNCTOR(zfabs, xt::fabs, math::fabs_fun);
     XTENSOR_BINARY_ZFUNCTOR(zfmod, xt::fmod, math::fmod_fun);
     XTENSOR_BINARY_ZFUNCTOR(zremainder, xt::remainder, math::remainder_fun);
-    //XTENSOR_TERNARY_ZFUNCTOR(fma);
+    XTENSOR_TERNARY_ZFUNCTOR(zfma, xt::fma, math::fma_fun);
+    XTENSOR_TERNARY_ZFUNCTOR(zclip, xt::clip, math::clamp_fun);
+    XTENSOR_TERNARY_ZFUNCTOR(zwhere, xt::where, detail::conditional_ternary);
     XTENSOR_BINARY_ZFUNCTOR(zfmax, xt::fmax, math::fmax_fun);
     XTENSOR_BINARY_ZFUNCTOR(zfmin, xt::fmin, math::fmin_fun);
     XTENSOR_BINARY_ZFUNCTOR(zfdim, xt::fdim, math::fdim_fun);
@@ -200,6 +263,7 @@ namespace xt
 
 
 
+#undef XTENSOR_TERNARY_ZFUNCTOR
 #undef XTENSOR_BINARY_ZFUNCTOR
 #undef XTENSOR_UNARY_ZFUNCTOR
 #undef XTENSOR_BINARY_ZOPERATOR
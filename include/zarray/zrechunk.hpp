@@ -0,0 +1,359 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XTENSOR_ZRECHUNK_HPP
+#define XTENSOR_ZRECHUNK_HPP
+
+#include <stdexcept>
+#include <vector>
+
+#include "zarray_zarray.hpp"
+#include "zdispatcher.hpp"
+
+namespace xt
+{
+    /*****************
+     * zrechunk_plan *
+     *****************/
+
+    // Copying a chunked array into a chunked array with a different chunk
+    // shape is done block by block. A block is a multiple of the target
+    // chunk shape: it is filled from the source chunks intersecting it,
+    // then split into target chunks. Blocks aligned on the source chunks
+    // read each source chunk once; smaller blocks reduce the memory
+    // footprint at the cost of reading source chunks several times.
+    struct zrechunk_plan
+    {
+        using shape_type = dynamic_shape<std::size_t>;
+
+        shape_type block_shape;
+        // Upper bound of the number of reads of a source chunk
+        std::size_t source_reads;
+    };
+
+    // max_buffer_size is the number of elements that can be held in memory
+    // at once, i.e. a block, a source chunk and a target chunk.
+    template <class S>
+    zrechunk_plan make_rechunk_plan(const S& shape,
+                                    const S& source_chunk_shape,
+                                    const S& target_chunk_shape,
+                                    std::size_t max_buffer_size);
+
+    // Chunk shape of an intermediate array dividing both chunk shapes: the
+    // blocks of the rechunk from the source to the intermediate array are
+    // single source chunks, the ones of the rechunk from the intermediate
+    // array to the target are single target chunks, and both rechunks read
+    // each chunk once. The intermediate chunks are small when the chunk
+    // shapes have small common divisors.
+    template <class S>
+    S rechunk_intermediate_shape(const S& source_chunk_shape, const S& target_chunk_shape);
+
+    void rechunk(const zarray& source, zarray& target, std::size_t max_buffer_size);
+    void rechunk(const zarray& source, zarray& intermediate, zarray& target, std::size_t max_buffer_size);
+
+    /********************
+     * zrechunk_functor *
+     ********************/
+
+    namespace detail
+    {
+        struct xrechunk_dummy_functor {};
+
+        template <>
+        struct unary_dispatching_types<xrechunk_dummy_functor>
+        {
+            using type = zunary_ident_types;
+        };
+
+        template <class T>
+        void run_rechunk(const ztyped_chunked_array<T>& source,
+                         ztyped_chunked_array<T>& target,
+                         const zrechunk_plan& plan);
+    }
+
+    struct zrechunk_functor
+    {
+        template <class T, class R>
+        static void run(const ztyped_array<T>& z, ztyped_array<R>& zres, const zrechunk_plan& plan)
+        {
+            const auto& source = static_cast<const ztyped_chunked_array<T>&>(z);
+            auto& target = static_cast<ztyped_chunked_array<R>&>(zres);
+            detail::run_rechunk(source, target, plan);
+        }
+
+        template <class T>
+        static size_t index(const ztyped_array<T>&)
+        {
+            return ztyped_array<T>::get_class_static_index();
+        }
+    };
+
+    template <>
+    struct get_zmapped_functor<detail::xrechunk_dummy_functor>
+    {
+        using type = zrechunk_functor;
+    };
+
+    using zrechunk_dispatcher = zdouble_dispatcher<detail::xrechunk_dummy_functor,
+                                                   mpl::vector<const zrechunk_plan>>;
+
+    /********************************
+     * zrechunk_plan implementation *
+     ********************************/
+
+    namespace detail
+    {
+        inline std::size_t zgcd(std::size_t a, std::size_t b)
+        {
+            while (b != 0)
+            {
+                std::size_t r = a % b;
+                a = b;
+                b = r;
+            }
+            return a;
+        }
+
+        template <class S>
+        inline std::size_t shape_size(const S& shape)
+        {
+            return std::accumulate(shape.cbegin(), shape.cend(), std::size_t(1), std::multiplies<std::size_t>());
+        }
+
+        // Row-major increment of index within [first, last], returns
+        // false once every index has been visited
+        inline bool next_grid_index(std::vector<std::size_t>& index,
+                                    const std::vector<std::size_t>& first,
+                                    const std::vector<std::size_t>& last)
+        {
+            for (std::size_t d = index.size(); d != 0; --d)
+            {
+                if (index[d - 1] != last[d - 1])
+                {
+                    ++index[d - 1];
+                    return true;
+                }
+                index[d - 1] = first[d - 1];
+            }
+            return false;
+        }
+
+        inline std::size_t ravel_grid_index(const std::vector<std::size_t>& index, const std::vector<std::size_t>& grid_shape)
+        {
+            std::size_t res = 0;
+            for (std::size_t d = 0; d < index.size(); ++d)
+            {
+                res = res * grid_shape[d] + index[d];
+            }
+            return res;
+        }
+    }
+
+    template <class S>
+    inline zrechunk_plan make_rechunk_plan(const S& shape,
+                                           const S& source_chunk_shape,
+                                           const S& target_chunk_shape,
+                                           std::size_t max_buffer_size)
+    {
+        std::size_t dim = shape.size();
+        zrechunk_plan plan;
+        plan.block_shape.resize(dim);
+
+        // Blocks aligned on both chunk shapes, unless they exceed the array
+        for (std::size_t d = 0; d < dim; ++d)
+        {
+            std::size_t s = source_chunk_shape[d];
+            std::size_t t = target_chunk_shape[d];
+            std::size_t full = (shape[d] + t - 1) / t * t;
+            std::size_t lcm = s / detail::zgcd(s, t) * t;
+            plan.block_shape[d] = (std::min)(lcm, (std::max)(full, t));
+        }
+
+        // Shrink the largest blocks until they fit in the buffer, with
+        // the source chunk read and the target chunk being assigned
+        std::size_t chunk_sizes = detail::shape_size(source_chunk_shape) + detail::shape_size(target_chunk_shape);
+        while (detail::shape_size(plan.block_shape) + chunk_sizes > max_buffer_size)
+        {
+            std::size_t shrinked = dim;
+            std::size_t max_ratio = 1;
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                std::size_t ratio = plan.block_shape[d] / target_chunk_shape[d];
+                if (ratio > max_ratio)
+                {
+                    max_ratio = ratio;
+                    shrinked = d;
+                }
+            }
+            if (shrinked == dim)
+            {
+                throw std::runtime_error("rechunk: buffer cannot hold a source chunk and a target chunk");
+            }
+            std::size_t t = target_chunk_shape[shrinked];
+            plan.block_shape[shrinked] = (std::max)(t, plan.block_shape[shrinked] / 2 / t * t);
+        }
+
+        plan.source_reads = 1;
+        for (std::size_t d = 0; d < dim; ++d)
+        {
+            std::size_t s = source_chunk_shape[d];
+            std::size_t b = plan.block_shape[d];
+            if (b % s != 0 && b < shape[d])
+            {
+                std::size_t block_count = (shape[d] + b - 1) / b;
+                plan.source_reads *= (std::min)(block_count, (s + b - 2) / b + 1);
+            }
+        }
+        return plan;
+    }
+
+    template <class S>
+    inline S rechunk_intermediate_shape(const S& source_chunk_shape, const S& target_chunk_shape)
+    {
+        S res = source_chunk_shape;
+        for (std::size_t d = 0; d < res.size(); ++d)
+        {
+            res[d] = detail::zgcd(source_chunk_shape[d], target_chunk_shape[d]);
+        }
+        return res;
+    }
+
+    /**************************
+     * rechunk implementation *
+     **************************/
+
+    namespace detail
+    {
+        template <class T>
+        inline void run_rechunk(const ztyped_chunked_array<T>& source,
+                                ztyped_chunked_array<T>& target,
+                                const zrechunk_plan& plan)
+        {
+            const auto& shape = source.shape();
+            const auto& source_chunk_shape = source.chunk_shape();
+            const auto& target_chunk_shape = target.chunk_shape();
+            const auto& block_shape = plan.block_shape;
+            std::size_t dim = shape.size();
+            if (dim == 0 || shape_size(shape) == 0)
+            {
+                return;
+            }
+
+            std::vector<std::size_t> source_grid(dim), target_grid(dim);
+            for (std::size_t d = 0; d < dim; ++d)
+            {
+                source_grid[d] = (shape[d] + source_chunk_shape[d] - 1) / source_chunk_shape[d];
+                target_grid[d] = (shape[d] + target_chunk_shape[d] - 1) / target_chunk_shape[d];
+            }
+
+            // Blocks are processed in the traversal order of the target
+            zchunk_grid block_grid(shape, block_shape);
+            block_grid.set_traversal(target.traversal_order());
+
+            std::vector<std::size_t> lo(dim), hi(dim), first(dim), last(dim), chunk(dim);
+            dynamic_shape<std::size_t> buffer_shape(dim);
+            auto block_end = zchunked_iterator(block_grid, block_grid.size());
+            for (auto block_it = zchunked_iterator(block_grid, 0u); block_it != block_end; ++block_it)
+            {
+                const auto& block = block_it.chunk_coords();
+                for (std::size_t d = 0; d < dim; ++d)
+                {
+                    lo[d] = block[d] * block_shape[d];
+                    hi[d] = (std::min)(lo[d] + block_shape[d], shape[d]);
+                    buffer_shape[d] = hi[d] - lo[d];
+                }
+                auto buffer = xarray<T>::from_shape(buffer_shape);
+
+                // Gathers the source chunks intersecting the block
+                for (std::size_t d = 0; d < dim; ++d)
+                {
+                    first[d] = lo[d] / source_chunk_shape[d];
+                    last[d] = (hi[d] - 1) / source_chunk_shape[d];
+                }
+                chunk = first;
+                do
+                {
+                    xstrided_slice_vector buffer_slices(dim), chunk_slices(dim);
+                    for (std::size_t d = 0; d < dim; ++d)
+                    {
+                        std::size_t chunk_start = chunk[d] * source_chunk_shape[d];
+                        std::size_t start = (std::max)(lo[d], chunk_start);
+                        std::size_t stop = (std::min)(hi[d], chunk_start + source_chunk_shape[d]);
+                        buffer_slices[d] = xt::range(start - lo[d], stop - lo[d]);
+                        chunk_slices[d] = xt::range(start - chunk_start, stop - chunk_start);
+                    }
+                    xarray<T> source_chunk = source.read_chunk(zchunked_iterator(source.chunk_grid(), ravel_grid_index(chunk, source_grid)));
+                    xt::noalias(xt::strided_view(buffer, buffer_slices)) = xt::strided_view(source_chunk, chunk_slices);
+                }
+                while (next_grid_index(chunk, first, last));
+
+                // Splits the block into target chunks, blocks being aligned
+                // on the target chunk grid
+                for (std::size_t d = 0; d < dim; ++d)
+                {
+                    first[d] = lo[d] / target_chunk_shape[d];
+                    last[d] = (hi[d] - 1) / target_chunk_shape[d];
+                }
+                chunk = first;
+                do
+                {
+                    xstrided_slice_vector buffer_slices(dim);
+                    for (std::size_t d = 0; d < dim; ++d)
+                    {
+                        std::size_t start = chunk[d] * target_chunk_shape[d];
+                        std::size_t stop = (std::min)(start + target_chunk_shape[d], hi[d]);
+                        buffer_slices[d] = xt::range(start - lo[d], stop - lo[d]);
+                    }
+                    xarray<T> target_chunk = xt::strided_view(buffer, buffer_slices);
+                    target.assign_chunk(std::move(target_chunk), zchunked_iterator(target.chunk_grid(), ravel_grid_index(chunk, target_grid)));
+                }
+                while (next_grid_index(chunk, first, last));
+            }
+        }
+
+        inline void check_rechunk_arguments(const zarray& source, const zarray& target)
+        {
+            const zarray_impl& source_impl = source.get_implementation();
+            const zarray_impl& target_impl = target.get_implementation();
+            if (!source_impl.is_chunked() || !target_impl.is_chunked())
+            {
+                throw std::runtime_error("rechunk: arrays must be chunked");
+            }
+            if (source_impl.get_class_index() != target_impl.get_class_index())
+            {
+                throw std::runtime_error("rechunk: arrays must have the same value type");
+            }
+            if (source_impl.shape() != target_impl.shape())
+            {
+                throw std::runtime_error("rechunk: arrays must have the same shape");
+            }
+        }
+    }
+
+    inline void rechunk(const zarray& source, zarray& target, std::size_t max_buffer_size)
+    {
+        detail::check_rechunk_arguments(source, target);
+        zrechunk_plan plan = make_rechunk_plan(source.shape(),
+                                               source.as_chunked_array().chunk_shape(),
+                                               target.as_chunked_array().chunk_shape(),
+                                               max_buffer_size);
+        zrechunk_dispatcher::dispatch(source.get_implementation(), target.get_implementation(), plan);
+    }
+
+    // Rechunks through an intermediate array, typically with the chunk
+    // shape given by rechunk_intermediate_shape, when a direct rechunk
+    // would read the source chunks too many times.
+    inline void rechunk(const zarray& source, zarray& intermediate, zarray& target, std::size_t max_buffer_size)
+    {
+        rechunk(source, intermediate, max_buffer_size);
+        rechunk(intermediate, target, max_buffer_size);
+    }
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include "zreducer_options.hpp"
 #include "zarray_zarray.hpp"
 #include "zarray_impl_register.hpp"
+#include "ztracer.hpp"
 
 namespace xt
 {
@@ -95,6 +96,7 @@ namespace xt
 
 
         void init_result_shape();
+        nlohmann::json reducer_trace_args() const;
     };
 
     template <class F, class CT>
@@ -124,10 +126,31 @@ namespace xt
         return xt::broadcast_shape(m_shape, shape);
     }
 
+    // Partially reducing a chunked array gives a chunked array, whose
+    // chunks are the chunks of the input along the axes that are not reduced
     template <class F, class CT>
     std::unique_ptr<zarray_impl> zreducer<F,CT>::allocate_result() const
     {
         std::size_t idx = get_result_type_index();
+        const zarray_impl& input = m_e.get_implementation();
+        const auto& axes = m_reducer_options.axes();
+        if (input.is_chunked() && axes.size() < input.dimension())
+        {
+            const auto& input_chunk_shape = m_e.as_chunked_array().chunk_shape();
+            shape_type chunk_shape;
+            for (std::size_t i = 0; i < input_chunk_shape.size(); ++i)
+            {
+                if (std::find(axes.begin(), axes.end(), i) == axes.end())
+                {
+                    chunk_shape.push_back(input_chunk_shape[i]);
+                }
+                else if (m_reducer_options.keep_dims())
+                {
+                    chunk_shape.push_back(1u);
+                }
+            }
+            return std::unique_ptr<zarray_impl>(zarray_impl_register::make_chunked(idx, m_shape, chunk_shape));
+        }
         return std::unique_ptr<zarray_impl>(zarray_impl_register::get(idx).clone());
     }
 
@@ -141,6 +164,8 @@ namespace xt
     template <class F, class CT>
     zarray_impl& zreducer<F,CT>::assign_to(zarray_impl& res, const zassign_args& args) const
     {
+        ZARRAY_TRACE_SCOPE(trace, "reducer", detail::ztrace_type_name<F>());
+        ZARRAY_TRACE_ARGS(trace, reducer_trace_args());
 
         if(m_reducer_options.has_initial_value())
         {
@@ -155,6 +180,16 @@ namespace xt
     }
 
 
+    template <class F, class CT>
+    nlohmann::json zreducer<F,CT>::reducer_trace_args() const
+    {
+        nlohmann::json trace_args;
+        trace_args["input_shape"] = detail::ztrace_shape(m_e.shape());
+        trace_args["axes"] = detail::ztrace_shape(m_reducer_options.axes());
+        trace_args["shape"] = detail::ztrace_shape(m_shape);
+        return trace_args;
+    }
+
     // this has a great overlap with xt::detail::shape_computation in xreducer
     template <class F, class CT>
     void zreducer<F,CT>::init_result_shape()
@@ -42,6 +42,47 @@ namespace xt
         return 0;
     }
 
+    namespace detail
+    {
+        // Reducers able to combine fill chunks analytically specialize
+        // this trait, see below.
+        template <class F>
+        struct zfill_chunk_reducer
+        {
+            static constexpr bool value = false;
+        };
+
+        template <class F, class T, class R>
+        bool zreduce_fill_chunks(const ztyped_array<T>& input_array,
+                                 ztyped_array<R>& zres,
+                                 const zassign_args& assign_args,
+                                 const zreducer_options& options);
+
+        // Slices of the input of a reducer contributing to the result
+        // slices: the whole reduced axes, the result slices otherwise
+        inline xstrided_slice_vector zreducer_input_slices(std::size_t dimension,
+                                                           const zreducer_options& options,
+                                                           const xstrided_slice_vector& slices)
+        {
+            const auto& axes = options.axes();
+            xstrided_slice_vector res(dimension);
+            std::size_t j = 0;
+            for (std::size_t i = 0; i < dimension; ++i)
+            {
+                if (std::find(axes.begin(), axes.end(), i) != axes.end())
+                {
+                    res[i] = xt::all();
+                    j += options.keep_dims() ? 1u : 0u;
+                }
+                else
+                {
+                    res[i] = slices[j++];
+                }
+            }
+            return res;
+        }
+    }
+
     template<class F>
     struct zreducer_functor
     {
@@ -63,6 +104,11 @@ namespace xt
         const zreducer_options& options
     )
     {
+        if (detail::zreduce_fill_chunks<F>(input_array, zres, assign_args, options))
+        {
+            return;
+        }
+
         if (!assign_args.chunk_assign)
         {
             options.visit_reducer_options<T>(false /*force_lazy*/,[&assign_args, &input_array, &zres](auto&&... reduce_args)
@@ -71,6 +117,17 @@ namespace xt
                 zassign_wrapped_expression(zres, std::move(res_expr), assign_args);
             });
         }
+        else if (input_array.is_chunked())
+        {
+            // Only the input chunks intersecting the result chunk along
+            // the axes that are not reduced are read, and reduced
+            const xarray<T> input = input_array.get_chunk(detail::zreducer_input_slices(input_array.dimension(), options, assign_args.slices()));
+            options.visit_reducer_options<T>(true /*force_lazy*/, [&assign_args, &input, &zres](auto&&... reduce_args)
+            {
+                auto res_expr = F::run(input, std::forward<decltype(reduce_args)>(reduce_args)...);
+                zassign_wrapped_expression(zres, std::move(res_expr), assign_args);
+            });
+        }
         else
         {
             options.visit_reducer_options<T>(true /*force_lazy*/, [&assign_args, &input_array, &zres](auto&&... reduce_args)
@@ -178,6 +235,207 @@ namespace xt
     XTENSOR_ZREDUCER_FUNCTOR_HELPER(znorm_induced_l1_zreducer_functor,   norm_induced_l1)
     XTENSOR_ZREDUCER_FUNCTOR_HELPER(znorm_induced_linf_zreducer_functor, norm_induced_linf)
 
+    /***********************
+     * fill chunk reducers *
+     ***********************/
+
+    namespace detail
+    {
+        template <class R>
+        inline R zpower(R base, std::size_t exponent)
+        {
+            R res = R(1);
+            while (exponent != 0)
+            {
+                if (exponent & 1)
+                {
+                    res *= base;
+                }
+                base *= base;
+                exponent >>= 1;
+            }
+            return res;
+        }
+
+        template <>
+        struct zfill_chunk_reducer<zsum_zreducer_functor_helper>
+        {
+            static constexpr bool value = true;
+
+            template <class R, class T>
+            static R fill(const T& v, std::size_t count) { return static_cast<R>(v) * static_cast<R>(count); }
+
+            template <class R, class E>
+            static R chunk(const E& e)
+            {
+                return std::accumulate(e.cbegin(), e.cend(), R(0), [](R acc, const auto& v) { return acc + static_cast<R>(v); });
+            }
+
+            template <class R>
+            static R combine(const R& lhs, const R& rhs) { return lhs + rhs; }
+
+            template <class R, class T>
+            static bool statistics(const zchunk_statistics<T>&, R&) { return false; }
+
+            template <class R>
+            static R finalize(const R& acc, std::size_t) { return acc; }
+        };
+
+        template <>
+        struct zfill_chunk_reducer<zmean_zreducer_functor_helper> : zfill_chunk_reducer<zsum_zreducer_functor_helper>
+        {
+            template <class R>
+            static R finalize(const R& acc, std::size_t size) { return acc / static_cast<R>(size); }
+        };
+
+        template <>
+        struct zfill_chunk_reducer<zprod_zreducer_functor_helper>
+        {
+            static constexpr bool value = true;
+
+            template <class R, class T>
+            static R fill(const T& v, std::size_t count) { return zpower(static_cast<R>(v), count); }
+
+            template <class R, class E>
+            static R chunk(const E& e)
+            {
+                return std::accumulate(e.cbegin(), e.cend(), R(1), [](R acc, const auto& v) { return acc * static_cast<R>(v); });
+            }
+
+            template <class R>
+            static R combine(const R& lhs, const R& rhs) { return lhs * rhs; }
+
+            template <class R, class T>
+            static bool statistics(const zchunk_statistics<T>&, R&) { return false; }
+
+            template <class R>
+            static R finalize(const R& acc, std::size_t) { return acc; }
+        };
+
+        template <>
+        struct zfill_chunk_reducer<zamin_zreducer_functor_helper>
+        {
+            static constexpr bool value = true;
+
+            template <class R, class T>
+            static R fill(const T& v, std::size_t) { return static_cast<R>(v); }
+
+            template <class R, class E>
+            static R chunk(const E& e) { return static_cast<R>(*std::min_element(e.cbegin(), e.cend())); }
+
+            template <class R>
+            static R combine(const R& lhs, const R& rhs) { return (std::min)(lhs, rhs); }
+
+            template <class R, class T>
+            static bool statistics(const zchunk_statistics<T>& s, R& res)
+            {
+                res = static_cast<R>(s.min);
+                return s.null_count == 0;
+            }
+
+            template <class R>
+            static R finalize(const R& acc, std::size_t) { return acc; }
+        };
+
+        template <>
+        struct zfill_chunk_reducer<zamax_zreducer_functor_helper>
+        {
+            static constexpr bool value = true;
+
+            template <class R, class T>
+            static R fill(const T& v, std::size_t) { return static_cast<R>(v); }
+
+            template <class R, class E>
+            static R chunk(const E& e) { return static_cast<R>(*std::max_element(e.cbegin(), e.cend())); }
+
+            template <class R>
+            static R combine(const R& lhs, const R& rhs) { return (std::max)(lhs, rhs); }
+
+            template <class R, class T>
+            static bool statistics(const zchunk_statistics<T>& s, R& res)
+            {
+                res = static_cast<R>(s.max);
+                return s.null_count == 0;
+            }
+
+            template <class R>
+            static R finalize(const R& acc, std::size_t) { return acc; }
+        };
+
+        template <class F, class T, class R>
+        inline bool zreduce_fill_chunks_impl(const ztyped_array<T>&,
+                                             ztyped_array<R>&,
+                                             const zassign_args&,
+                                             const zreducer_options&,
+                                             std::false_type)
+        {
+            return false;
+        }
+
+        // Full reduction of a chunked array tracking fill chunks or chunk
+        // statistics: fill chunks are reduced from their value and size, and
+        // chunks whose statistics suffice from them, without reading any storage.
+        template <class F, class T, class R>
+        inline bool zreduce_fill_chunks_impl(const ztyped_array<T>& input_array,
+                                             ztyped_array<R>& zres,
+                                             const zassign_args& assign_args,
+                                             const zreducer_options& options,
+                                             std::true_type)
+        {
+            using reducer_type = zfill_chunk_reducer<F>;
+
+            if (assign_args.chunk_assign || !input_array.is_chunked() ||
+                options.has_initial_value() || options.axes().size() != input_array.dimension())
+            {
+                return false;
+            }
+
+            const auto& chunked_input = static_cast<const ztyped_chunked_array<T>&>(input_array);
+            bool has_statistics = chunked_input.has_chunk_statistics();
+            if ((!chunked_input.has_fill_value() && !has_statistics) || chunked_input.grid_size() == 0)
+            {
+                return false;
+            }
+
+            const auto& shape = input_array.shape();
+            const auto& chunk_shape = chunked_input.chunk_shape();
+            R acc = R();
+            bool first = true;
+            auto chunk_end = chunked_input.chunk_end();
+            for (auto it = chunked_input.chunk_begin(); it != chunk_end; ++it)
+            {
+                std::size_t index = it.chunk_index();
+                R partial = R();
+                if (chunked_input.is_fill_chunk(index))
+                {
+                    partial = reducer_type::template fill<R>(chunked_input.chunk_fill_value(index), chunk_size(shape, chunk_shape, index));
+                }
+                else if (!has_statistics || !reducer_type::statistics(chunked_input.chunk_statistics(index), partial))
+                {
+                    partial = reducer_type::template chunk<R>(chunked_input.read_chunk(it));
+                }
+                acc = first ? partial : reducer_type::combine(acc, partial);
+                first = false;
+            }
+            std::size_t size = std::accumulate(shape.cbegin(), shape.cend(), std::size_t(1), std::multiplies<std::size_t>());
+
+            auto res = xarray<R>::from_shape(zres.shape());
+            res.fill(reducer_type::finalize(acc, size));
+            zassign_wrapped_expression(zres, res, assign_args);
+            return true;
+        }
+
+        template <class F, class T, class R>
+        inline bool zreduce_fill_chunks(const ztyped_array<T>& input_array,
+                                        ztyped_array<R>& zres,
+                                        const zassign_args& assign_args,
+                                        const zreducer_options& options)
+        {
+            using supported = std::integral_constant<bool, zfill_chunk_reducer<F>::value>;
+            return zreduce_fill_chunks_impl<F>(input_array, zres, assign_args, options, supported());
+        }
+    }
+
 #undef XTENSOR_ZMAPPED_FUNCTOR
 
 }
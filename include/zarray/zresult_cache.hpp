@@ -0,0 +1,190 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XTENSOR_ZRESULT_CACHE_HPP
+#define XTENSOR_ZRESULT_CACHE_HPP
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "zarray_zarray.hpp"
+
+namespace xt
+{
+    /*****************
+     * zresult_cache *
+     *****************/
+
+    // Memoizes the results of zarray expressions. The key of a result is
+    // the structure of the expression, the identities and versions of its
+    // zarray operands and the values of its scalars: modifying an operand
+    // through its zarray invalidates the results depending on it. Data
+    // modified by other means, for instance through an xarray wrapped by
+    // reference, is not tracked and requires clearing the cache.
+    //
+    // Results are shared and read-only. The least recently used ones are
+    // evicted when their total size exceeds the byte budget. Expressions
+    // with reducers or lazy operands are evaluated without memoization.
+    // The cache is not thread-safe.
+    class zresult_cache
+    {
+    public:
+
+        using key_type = std::vector<std::size_t>;
+        using result_type = std::shared_ptr<const zarray>;
+
+        explicit zresult_cache(std::size_t byte_budget);
+
+        template <class E>
+        result_type evaluate(const xexpression<E>& e);
+
+        std::size_t byte_budget() const;
+        void set_byte_budget(std::size_t byte_budget);
+
+        std::size_t byte_size() const;
+        std::size_t size() const;
+        std::size_t hit_count() const;
+        std::size_t miss_count() const;
+
+        void clear();
+
+    private:
+
+        struct entry
+        {
+            result_type result;
+            std::size_t bytes;
+            std::list<const key_type*>::iterator lru_iter;
+        };
+
+        void insert(key_type&& key, const result_type& result);
+        void evict(std::size_t byte_budget);
+
+        std::size_t m_byte_budget;
+        std::size_t m_byte_size;
+        std::size_t m_hit_count;
+        std::size_t m_miss_count;
+
+        // most recently used keys first
+        std::list<const key_type*> m_lru;
+        std::map<key_type, entry> m_entries;
+    };
+
+    /********************************
+     * zresult_cache implementation *
+     ********************************/
+
+    inline zresult_cache::zresult_cache(std::size_t byte_budget)
+        : m_byte_budget(byte_budget)
+        , m_byte_size(0)
+        , m_hit_count(0)
+        , m_miss_count(0)
+        , m_lru()
+        , m_entries()
+    {
+    }
+
+    template <class E>
+    inline auto zresult_cache::evaluate(const xexpression<E>& e) -> result_type
+    {
+        const E& de = e.derived_cast();
+        key_type key;
+        if (detail::zlazy_operand_checker<E>::run(de) || !detail::zsubexpression_key_builder<E>::run(de, key))
+        {
+            return std::make_shared<const zarray>(de);
+        }
+
+        auto iter = m_entries.find(key);
+        if (iter != m_entries.end())
+        {
+            ++m_hit_count;
+            m_lru.splice(m_lru.begin(), m_lru, iter->second.lru_iter);
+            return iter->second.result;
+        }
+
+        ++m_miss_count;
+        result_type res = std::make_shared<const zarray>(de);
+        insert(std::move(key), res);
+        return res;
+    }
+
+    inline std::size_t zresult_cache::byte_budget() const
+    {
+        return m_byte_budget;
+    }
+
+    inline void zresult_cache::set_byte_budget(std::size_t byte_budget)
+    {
+        m_byte_budget = byte_budget;
+        evict(m_byte_budget);
+    }
+
+    inline std::size_t zresult_cache::byte_size() const
+    {
+        return m_byte_size;
+    }
+
+    inline std::size_t zresult_cache::size() const
+    {
+        return m_entries.size();
+    }
+
+    inline std::size_t zresult_cache::hit_count() const
+    {
+        return m_hit_count;
+    }
+
+    inline std::size_t zresult_cache::miss_count() const
+    {
+        return m_miss_count;
+    }
+
+    inline void zresult_cache::clear()
+    {
+        m_lru.clear();
+        m_entries.clear();
+        m_byte_size = 0;
+    }
+
+    // Results larger than the budget are not cached
+    inline void zresult_cache::insert(key_type&& key, const result_type& result)
+    {
+        const zarray_impl& impl = result->get_implementation();
+        const auto& shape = impl.shape();
+        std::size_t size = std::accumulate(shape.cbegin(), shape.cend(), std::size_t(1), std::multiplies<std::size_t>());
+        std::size_t bytes = size * zarray_impl_register::value_size(impl.get_class_index());
+        if (bytes > m_byte_budget)
+        {
+            return;
+        }
+
+        evict(m_byte_budget - bytes);
+        auto iter = m_entries.emplace(std::move(key), entry{result, bytes, m_lru.end()}).first;
+        m_lru.push_front(&(iter->first));
+        iter->second.lru_iter = m_lru.begin();
+        m_byte_size += bytes;
+    }
+
+    inline void zresult_cache::evict(std::size_t byte_budget)
+    {
+        while (m_byte_size > byte_budget)
+        {
+            auto iter = m_entries.find(*(m_lru.back()));
+            m_byte_size -= iter->second.bytes;
+            m_lru.pop_back();
+            m_entries.erase(iter);
+        }
+    }
+}
+
+#endif
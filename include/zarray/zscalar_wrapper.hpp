@@ -10,6 +10,9 @@
 #ifndef XTENSOR_ZSCALAR_WRAPPER_HPP
 #define XTENSOR_ZSCALAR_WRAPPER_HPP
 
+#include <atomic>
+#include <mutex>
+
 #include "zarray_impl.hpp"
 
 namespace xt
@@ -32,16 +35,18 @@ namespace xt
         template <class E>
         zscalar_wrapper(E&& e);
 
-        zscalar_wrapper(zscalar_wrapper&&) = default;
+        zscalar_wrapper(zscalar_wrapper&& rhs);
 
         virtual ~zscalar_wrapper() = default;
 
         bool is_array() const override;
         bool is_chunked() const override;
+        bool owns_buffer() const override;
 
         xarray<value_type>& get_array() override;
         const xarray<value_type>& get_array() const override;
         xarray<value_type> get_chunk(const slice_vector& slices) const override;
+        const value_type* scalar_value() const override;
 
         self_type* clone() const override;
         std::ostream& print(std::ostream& out) const override;
@@ -61,11 +66,21 @@ namespace xt
 
     private:
         
-        zscalar_wrapper(const zscalar_wrapper&) = default;
+        zscalar_wrapper(const zscalar_wrapper& rhs);
+
+        const xarray<value_type>& get_array_impl() const;
 
+        // The value is stored inline, the 0-D array is built only if
+        // the wrapper is used as an array, possibly concurrently. Once
+        // the array has been handed out for writing, it holds the value.
         CTE m_expression;
-        xarray<value_type> m_array;
-        nlohmann::json m_metadata;
+        value_type m_value;
+        shape_type m_shape;
+        mutable xarray<value_type> m_array;
+        mutable std::atomic<bool> m_array_initialized;
+        mutable std::mutex m_mutex;
+        bool m_array_writable;
+        zmetadata<value_type> m_metadata;
     };
 
     /**********************************
@@ -77,9 +92,41 @@ namespace xt
     inline zscalar_wrapper<CTE>::zscalar_wrapper(E&& e)
         : base_type()
         , m_expression(std::forward<E>(e))
-        , m_array(m_expression())
+        , m_value(m_expression())
+        , m_shape()
+        , m_array()
+        , m_array_initialized(false)
+        , m_mutex()
+        , m_array_writable(false)
+    {
+    }
+
+    template <class CTE>
+    inline zscalar_wrapper<CTE>::zscalar_wrapper(const zscalar_wrapper& rhs)
+        : base_type(rhs)
+        , m_expression(rhs.m_expression)
+        , m_value(*(rhs.scalar_value()))
+        , m_shape()
+        , m_array()
+        , m_array_initialized(false)
+        , m_mutex()
+        , m_array_writable(false)
+        , m_metadata(rhs.m_metadata)
+    {
+    }
+
+    template <class CTE>
+    inline zscalar_wrapper<CTE>::zscalar_wrapper(zscalar_wrapper&& rhs)
+        : base_type(rhs)
+        , m_expression(std::move(rhs.m_expression))
+        , m_value(*(rhs.scalar_value()))
+        , m_shape()
+        , m_array()
+        , m_array_initialized(false)
+        , m_mutex()
+        , m_array_writable(false)
+        , m_metadata(rhs.m_metadata)
     {
-        detail::set_data_type<value_type>(m_metadata);
     }
 
     template <class CTE>
@@ -94,21 +141,51 @@ namespace xt
         return false;
     }
 
+    template <class CTE>
+    bool zscalar_wrapper<CTE>::owns_buffer() const
+    {
+        return false;
+    }
+
     template <class CTE>
     auto zscalar_wrapper<CTE>::get_array() -> xarray<value_type>&
     {
+        this->update_version();
+        get_array_impl();
+        m_array_writable = true;
         return m_array;
     }
 
     template <class CTE>
     auto zscalar_wrapper<CTE>::get_array() const -> const xarray<value_type>&
     {
-        return m_array;
+        return get_array_impl();
     }
 
     template <class CTE>
     auto zscalar_wrapper<CTE>::get_chunk(const slice_vector&) const -> xarray<value_type>
     {
+        return xarray<value_type>(*scalar_value());
+    }
+
+    template <class CTE>
+    auto zscalar_wrapper<CTE>::scalar_value() const -> const value_type*
+    {
+        return m_array_writable ? m_array.data() : &m_value;
+    }
+
+    template <class CTE>
+    auto zscalar_wrapper<CTE>::get_array_impl() const -> const xarray<value_type>&
+    {
+        if (!m_array_initialized.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_array_initialized.load(std::memory_order_relaxed))
+            {
+                m_array = xarray<value_type>(m_value);
+                m_array_initialized.store(true, std::memory_order_release);
+            }
+        }
         return m_array;
     }
 
@@ -121,38 +198,39 @@ namespace xt
     template <class CTE>
     std::ostream& zscalar_wrapper<CTE>::print(std::ostream& out) const
     {
-        return out << m_expression;
+        return out << get_array_impl();
     }
 
     template <class CTE>
     zarray_impl* zscalar_wrapper<CTE>::strided_view(slice_vector& slices)
     {
-        auto e = xt::strided_view(m_array, slices);
+        this->update_version();
+        auto e = xt::strided_view(get_array(), slices);
         return detail::build_zarray(std::move(e));
     }
 
     template <class CTE>
     auto zscalar_wrapper<CTE>::get_metadata() const -> const nlohmann::json&
     {
-        return m_metadata;
+        return m_metadata.get();
     }
 
     template <class CTE>
     void zscalar_wrapper<CTE>::set_metadata(const nlohmann::json& metadata)
     {
-        m_metadata = metadata;
+        m_metadata.set(metadata);
     }
 
     template <class CTE>
     std::size_t zscalar_wrapper<CTE>::dimension() const
     {
-        return m_array.dimension();
+        return 0u;
     }
 
     template <class CTE>
     auto zscalar_wrapper<CTE>::shape() const -> const shape_type&
     {
-        return m_array.shape();
+        return m_shape;
     }
 
     template <class CTE>
@@ -180,9 +258,10 @@ namespace xt
     }
 
     template <class CTE>
-    bool zscalar_wrapper<CTE>::broadcast_shape(shape_type& shape, bool reuse_cache) const
+    bool zscalar_wrapper<CTE>::broadcast_shape(shape_type&, bool) const
     {
-        return m_array.broadcast_shape(shape, reuse_cache);
+        // Like xscalar, a scalar does not prevent linear assignment
+        return true;
     }
 }
 
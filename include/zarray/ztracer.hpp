@@ -0,0 +1,328 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#ifndef XTENSOR_ZTRACER_HPP
+#define XTENSOR_ZTRACER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
+#include <nlohmann/json.hpp>
+
+#include "zarray_config.hpp"
+
+namespace xt
+{
+    /***********
+     * ztracer *
+     ***********/
+
+    // Records begin and end events of the kernels, temporary buffers,
+    // chunks and reducers evaluated by zarray. Events are recorded when
+    // zarray is built with ZARRAY_TRACING and the tracer is enabled,
+    // and are exported in the Chrome trace format (chrome://tracing,
+    // Perfetto). Timestamps are relative to the construction of the
+    // tracer. The tracer is thread-safe.
+    class ztracer
+    {
+    public:
+
+        static ztracer& instance();
+
+        void enable();
+        void disable();
+        bool is_enabled() const;
+
+        void begin(const char* category, const std::string& name);
+        void end(const char* category, const std::string& name, nlohmann::json args);
+
+        std::size_t size() const;
+        void clear();
+
+        nlohmann::json to_json() const;
+        void write(std::ostream& out) const;
+        void dump(const std::string& filename) const;
+
+    private:
+
+        struct event
+        {
+            char phase;
+            const char* category;
+            std::string name;
+            double timestamp;
+            std::size_t thread;
+            nlohmann::json args;
+        };
+
+        ztracer();
+        ~ztracer() = default;
+
+        void record(char phase, const char* category, const std::string& name, nlohmann::json&& args);
+
+        std::atomic<bool> m_enabled;
+        std::chrono::steady_clock::time_point m_origin;
+        mutable std::mutex m_mutex;
+        std::vector<event> m_events;
+        // threads are numbered in the order of their first event
+        std::map<std::thread::id, std::size_t> m_threads;
+    };
+
+    /****************
+     * ztrace_scope *
+     ****************/
+
+    // Records a begin event on construction and the matching end event
+    // on destruction if the tracer is enabled. The name is only computed
+    // in this case. The arguments of the end event are merged with the
+    // ones of the begin event by the trace viewers.
+    class ztrace_scope
+    {
+    public:
+
+        template <class N>
+        ztrace_scope(const char* category, N&& name);
+        ~ztrace_scope();
+
+        ztrace_scope(const ztrace_scope&) = delete;
+        ztrace_scope& operator=(const ztrace_scope&) = delete;
+
+        bool is_active() const;
+        nlohmann::json& args();
+
+    private:
+
+        bool m_active;
+        const char* m_category;
+        std::string m_name;
+        nlohmann::json m_args;
+    };
+
+    /******************
+     * tracing macros *
+     ******************/
+
+    // NAME and ARGS are only evaluated when the tracer is enabled; they
+    // must not contain unparenthesized commas. Without ZARRAY_TRACING
+    // the macros expand to nothing.
+#if ZARRAY_TRACING
+#define ZARRAY_TRACE_SCOPE(VAR, CATEGORY, NAME) \
+    ::xt::ztrace_scope VAR(CATEGORY, [&]() { return NAME; })
+#define ZARRAY_TRACE_ARGS(VAR, ARGS) \
+    if (VAR.is_active())             \
+    {                                \
+        VAR.args() = ARGS;           \
+    }
+#else
+#define ZARRAY_TRACE_SCOPE(VAR, CATEGORY, NAME)
+#define ZARRAY_TRACE_ARGS(VAR, ARGS)
+#endif
+
+    namespace detail
+    {
+        // Unqualified name of the type T, used as the name of
+        // the events of the functors and reducers
+        template <class T>
+        std::string ztrace_type_name();
+
+        template <class S>
+        nlohmann::json ztrace_shape(const S& shape);
+    }
+
+    /**************************
+     * ztracer implementation *
+     **************************/
+
+    inline ztracer& ztracer::instance()
+    {
+        static ztracer tracer;
+        return tracer;
+    }
+
+    inline ztracer::ztracer()
+        : m_enabled(false)
+        , m_origin(std::chrono::steady_clock::now())
+        , m_mutex()
+        , m_events()
+        , m_threads()
+    {
+    }
+
+    inline void ztracer::enable()
+    {
+        m_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    inline void ztracer::disable()
+    {
+        m_enabled.store(false, std::memory_order_relaxed);
+    }
+
+    inline bool ztracer::is_enabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    inline void ztracer::begin(const char* category, const std::string& name)
+    {
+        record('B', category, name, nlohmann::json::object());
+    }
+
+    inline void ztracer::end(const char* category, const std::string& name, nlohmann::json args)
+    {
+        record('E', category, name, std::move(args));
+    }
+
+    inline std::size_t ztracer::size() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_events.size();
+    }
+
+    inline void ztracer::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.clear();
+    }
+
+    inline nlohmann::json ztracer::to_json() const
+    {
+        nlohmann::json events = nlohmann::json::array();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& e : m_events)
+            {
+                nlohmann::json je;
+                je["name"] = e.name;
+                je["cat"] = e.category;
+                je["ph"] = std::string(1, e.phase);
+                je["ts"] = e.timestamp;
+                je["pid"] = 1;
+                je["tid"] = e.thread;
+                if (!e.args.empty())
+                {
+                    je["args"] = e.args;
+                }
+                events.push_back(std::move(je));
+            }
+        }
+        nlohmann::json res;
+        res["traceEvents"] = std::move(events);
+        res["displayTimeUnit"] = "ns";
+        return res;
+    }
+
+    inline void ztracer::write(std::ostream& out) const
+    {
+        out << to_json().dump();
+    }
+
+    inline void ztracer::dump(const std::string& filename) const
+    {
+        std::ofstream out(filename);
+        if (!out)
+        {
+            throw std::runtime_error("ztracer: cannot open " + filename);
+        }
+        write(out);
+    }
+
+    inline void ztracer::record(char phase, const char* category, const std::string& name, nlohmann::json&& args)
+    {
+        auto now = std::chrono::steady_clock::now();
+        double timestamp = std::chrono::duration<double, std::micro>(now - m_origin).count();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_threads.emplace(std::this_thread::get_id(), m_threads.size()).first;
+        m_events.push_back(event{phase, category, name, timestamp, iter->second, std::move(args)});
+    }
+
+    /*******************************
+     * ztrace_scope implementation *
+     *******************************/
+
+    template <class N>
+    inline ztrace_scope::ztrace_scope(const char* category, N&& name)
+        : m_active(ztracer::instance().is_enabled())
+        , m_category(category)
+        , m_name()
+        , m_args()
+    {
+        if (m_active)
+        {
+            m_name = name();
+            ztracer::instance().begin(m_category, m_name);
+        }
+    }
+
+    inline ztrace_scope::~ztrace_scope()
+    {
+        if (m_active)
+        {
+            ztracer::instance().end(m_category, m_name, std::move(m_args));
+        }
+    }
+
+    inline bool ztrace_scope::is_active() const
+    {
+        return m_active;
+    }
+
+    inline nlohmann::json& ztrace_scope::args()
+    {
+        return m_args;
+    }
+
+    namespace detail
+    {
+        template <class T>
+        inline std::string ztrace_type_name()
+        {
+            std::string name = typeid(T).name();
+#if defined(__GNUC__)
+            int status = 0;
+            std::unique_ptr<char, void (*)(void*)> demangled(abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status), std::free);
+            if (status == 0)
+            {
+                name = demangled.get();
+            }
+#endif
+            std::size_t pos = name.rfind("::");
+            return pos == std::string::npos ? name : name.substr(pos + 2u);
+        }
+
+        template <class S>
+        inline nlohmann::json ztrace_shape(const S& shape)
+        {
+            nlohmann::json res = nlohmann::json::array();
+            for (auto s : shape)
+            {
+                res.push_back(s);
+            }
+            return res;
+        }
+    }
+}
+
+#endif
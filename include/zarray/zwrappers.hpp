@@ -12,7 +12,9 @@
 
 #include "zarray_wrapper.hpp"
 #include "zchunked_wrapper.hpp"
+#include "zchunked_view_wrapper.hpp"
 #include "zexpression_wrapper.hpp"
+#include "zlazy_wrapper.hpp"
 #include "zscalar_wrapper.hpp"
 
 #endif
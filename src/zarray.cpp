@@ -0,0 +1,24 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+// Translation unit of the zarray compiled library: the explicit
+// instantiations of zinit.hpp and the register of implementations
+// are defined here
+
+#define ZARRAY_LIBRARY_SOURCE
+
+#include "zarray/zarray.hpp"
+
+namespace xt
+{
+    int init_zsystem()
+    {
+        return init_zsystem<void>();
+    }
+}
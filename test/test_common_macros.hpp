@@ -12,6 +12,7 @@
 #define EXPECT_GT(A,B) CHECK_GT(A,B)
 #define EXPECT_TRUE(A) CHECK_EQ(A, true)
 #define EXPECT_FALSE(A) CHECK_FALSE(A)
+#define EXPECT_THROW(A, E) CHECK_THROWS_AS(A, E)
 
 #define ASSERT_EQ(A,B) REQUIRE_EQ(A,B)
 #define ASSERT_NE(A,B) REQUIRE_NE(A,B)
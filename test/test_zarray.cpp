@@ -9,6 +9,9 @@
 
 #include "test_common.hpp"
 
+#include <thread>
+#include <vector>
+
 #include <zarray/zarray.hpp>
 #include <xtl/xplatform.hpp>
 #include <xtl/xhalf_float.hpp>
@@ -147,6 +150,28 @@ namespace xt{
         EXPECT_EQ(db.get_array<double>(), c);
     }
 
+    TEST(zarray, same_type_copy_move)
+    {
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        xarray<double> b = {{5., 6.}, {7., 8.}};
+
+        // The copy reuses the buffer of the destination
+        zarray da(a);
+        zarray db = xt::xarray<double>(b);
+        const double* data = a.data();
+        da = db;
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(a.data(), data);
+        EXPECT_NE(a.data(), db.get_array<double>().data());
+
+        // The move takes the buffer of the source
+        zarray dc = xt::xarray<double>(a);
+        const double* moved_data = db.get_array<double>().data();
+        dc = std::move(db);
+        EXPECT_EQ(dc.get_array<double>(), b);
+        EXPECT_EQ(dc.get_array<double>().data(), moved_data);
+    }
+
     TEST(zarray, extended_copy)
     {
         zdispatcher_t<detail::plus, 2>::init();
@@ -257,6 +282,198 @@ namespace xt{
         EXPECT_EQ(a1, a2);
     }
 
+    TEST(zarray, compound_assign)
+    {
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        xarray<double> b = {5., 6.};
+        zarray za(a);
+        zarray zb(b);
+        const double* data = za.get_array<double>().data();
+
+        za += zb;
+        xarray<double> expected1 = {{6., 8.}, {8., 10.}};
+        EXPECT_EQ(za.get_array<double>(), expected1);
+        EXPECT_EQ(za.get_array<double>().data(), data);
+
+        za -= zb * zb;
+        xarray<double> expected2 = {{-19., -28.}, {-17., -26.}};
+        EXPECT_EQ(za.get_array<double>(), expected2);
+        EXPECT_EQ(za.get_array<double>().data(), data);
+
+        za *= 2.;
+        xarray<double> expected3 = {{-38., -56.}, {-34., -52.}};
+        EXPECT_EQ(za.get_array<double>(), expected3);
+        EXPECT_EQ(za.get_array<double>().data(), data);
+
+        // The result is broadcast to a larger shape
+        zarray zc(b);
+        zc += za;
+        xarray<double> expected4 = {{-33., -50.}, {-29., -46.}};
+        EXPECT_EQ(zc.get_array<double>(), expected4);
+    }
+
+    TEST(zarray, lazy)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::multiplies, 2>::init();
+
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        xarray<double> b = {{5., 6.}, {7., 8.}};
+        zarray za(a);
+        zarray zb(b);
+
+        zarray l1 = zt::lazy(za + zb);
+        zarray l2 = zt::lazy(l1 * l1);
+        zarray l4 = zt::lazy(l1 + za);
+        EXPECT_TRUE(l1.is_lazy());
+        EXPECT_TRUE(l2.is_lazy());
+
+        // l1 is computed once, on its first use by l2, and its
+        // result is kept for its other uses
+        l2.evaluate();
+        xarray<double> expected2 = {{36., 64.}, {100., 144.}};
+        EXPECT_FALSE(l2.is_lazy());
+        EXPECT_FALSE(l1.is_lazy());
+        EXPECT_EQ(l2.get_array<double>(), expected2);
+
+        // l1 is not computed again: changes to its operands
+        // after its evaluation are not seen by its users
+        xarray<double> expected1 = {{6., 8.}, {10., 12.}};
+        zb.get_array<double>().fill(0.);
+        EXPECT_EQ(l1.get_array<double>(), expected1);
+        xarray<double> expected4 = {{7., 10.}, {13., 16.}};
+        EXPECT_EQ(l4.get_array<double>(), expected4);
+        zarray r = l1 * l1;
+        EXPECT_EQ(r.get_array<double>(), expected2);
+
+        // the operands are read when the expression is evaluated
+        zarray l3 = zt::lazy(za * zb);
+        za.get_array<double>()(0, 0) = 0.;
+        EXPECT_EQ(l3.get_array<double>()(0, 0), 0.);
+
+        // a lazy operand is evaluated with the expression using it, and
+        // its result is kept
+        zarray l5 = zt::lazy(za + za);
+        zarray r5 = l5 * za + za;
+        xarray<double> expected5 = {{0., 10.}, {21., 36.}};
+        EXPECT_FALSE(l5.is_lazy());
+        EXPECT_EQ(r5.get_array<double>(), expected5);
+        xarray<double> expected6 = {{0., 4.}, {6., 8.}};
+        EXPECT_EQ(l5.get_array<double>(), expected6);
+
+        // evaluate keeps the metadata
+        zarray l6 = zt::lazy(za + za);
+        nlohmann::json metadata;
+        metadata["foo"] = "bar";
+        l6.set_metadata(metadata);
+        l6.evaluate();
+        EXPECT_EQ(l6.get_metadata()["foo"], "bar");
+    }
+
+    TEST(zarray, lazy_threads)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        zarray za(a);
+        const zarray l = zt::lazy(za + za);
+
+        // the first accesses race to evaluate the expression
+        std::vector<const double*> results(4u, nullptr);
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            threads.emplace_back([&l, &results, i]() { results[i] = l.get_array<double>().data(); });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        for (auto r : results)
+        {
+            EXPECT_EQ(r, results[0]);
+        }
+        xarray<double> expected = {{2., 4.}, {6., 8.}};
+        EXPECT_EQ(l.get_array<double>(), expected);
+    }
+
+    TEST(zarray, result_cache)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        xarray<double> b = {{5., 6.}, {7., 8.}};
+        zarray za(a);
+        zarray zb(b);
+
+        zresult_cache cache(1024u);
+        auto r1 = cache.evaluate(za + zb);
+        auto r2 = cache.evaluate(za + zb);
+        EXPECT_EQ(r1.get(), r2.get());
+        EXPECT_EQ(cache.hit_count(), 1u);
+        EXPECT_EQ(cache.byte_size(), 4u * sizeof(double));
+
+        // modifying an operand invalidates the result
+        za.get_array<double>()(0, 0) = 0.;
+        auto r3 = cache.evaluate(za + zb);
+        EXPECT_NE(r1.get(), r3.get());
+        EXPECT_EQ(r1->get_array<double>()(0, 0), 6.);
+        EXPECT_EQ(r3->get_array<double>()(0, 0), 5.);
+
+        // the least recently used results are evicted
+        cache.set_byte_budget(4u * sizeof(double));
+        EXPECT_EQ(cache.size(), 1u);
+        auto r4 = cache.evaluate(za + zb);
+        EXPECT_EQ(r3.get(), r4.get());
+    }
+
+    TEST(zarray, result_cache_impl_writes)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+        zappend_dispatcher::init();
+
+        using shape_type = zarray::shape_type;
+        shape_type shape = {4, 4};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        xarray<double> b = xarray<double>::from_shape(shape);
+        b.fill(1.);
+        zarray za(a);
+        zarray zb(b);
+        za = zb;
+
+        // the implementation is written after the cache has seen its version
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        zresult_cache cache(1024u);
+        auto r1 = cache.evaluate(za + zb);
+        EXPECT_EQ(r1->get_array<double>()(0, 0), 2.);
+
+        xarray<double> chunk = {{5., 5.}, {5., 5.}};
+        ca.assign_chunk(std::move(chunk), ca.chunk_begin());
+        auto r2 = cache.evaluate(za + zb);
+        EXPECT_NE(r1.get(), r2.get());
+        EXPECT_EQ(r2->get_array<double>()(0, 0), 6.);
+        EXPECT_EQ(r2->get_array<double>()(3, 3), 2.);
+
+        ca.set_fill_value(0.);
+        auto r3 = cache.evaluate(za + zb);
+        EXPECT_NE(r2.get(), r3.get());
+        EXPECT_EQ(r3->get_array<double>()(0, 0), 1.);
+
+        zarray zc = appendable_chunked_array<double>(shape_type({0, 2}), shape_type({2, 2}));
+        auto& cc = dynamic_cast<zappendable_wrapper<double>&>(zc.get_implementation());
+        xarray<double> c0 = {{1., 2.}};
+        cc.append(c0);
+        auto r4 = cache.evaluate(zc + zc);
+        EXPECT_EQ(r4->shape(), shape_type({1, 2}));
+
+        cc.append(c0);
+        auto r5 = cache.evaluate(zc + zc);
+        EXPECT_NE(r4.get(), r5.get());
+        EXPECT_EQ(r5->shape(), shape_type({2, 2}));
+    }
+
     TEST(zarray, data_type)
     {
         std::string s = (xtl::endianness() == xtl::endian::little_endian) ? "<" : ">";
@@ -273,6 +490,69 @@ namespace xt{
         check_xarray_data_type<float>(s + "f4");
         check_xarray_data_type<double>(s + "f8");
     }
+
+    TEST(zarray, enabled_types)
+    {
+        EXPECT_EQ((mpl::contains<z_types, uint8_t>::value), bool(ZARRAY_ENABLE_UINT8));
+        EXPECT_EQ((mpl::contains<z_types, int8_t>::value), bool(ZARRAY_ENABLE_INT8));
+        EXPECT_EQ((mpl::contains<z_types, uint16_t>::value), bool(ZARRAY_ENABLE_UINT16));
+        EXPECT_EQ((mpl::contains<z_types, int16_t>::value), bool(ZARRAY_ENABLE_INT16));
+        EXPECT_EQ((mpl::contains<z_types, uint32_t>::value), bool(ZARRAY_ENABLE_UINT32));
+        EXPECT_EQ((mpl::contains<z_types, int32_t>::value), bool(ZARRAY_ENABLE_INT32));
+        EXPECT_EQ((mpl::contains<z_types, uint64_t>::value), bool(ZARRAY_ENABLE_UINT64));
+        EXPECT_EQ((mpl::contains<z_types, int64_t>::value), bool(ZARRAY_ENABLE_INT64));
+        EXPECT_EQ((mpl::contains<z_types, float>::value), bool(ZARRAY_ENABLE_FLOAT));
+        EXPECT_EQ((mpl::contains<z_types, double>::value), bool(ZARRAY_ENABLE_DOUBLE));
+
+        // combinations are dropped when their result type is disabled
+        using int16_to_int32 = mpl::vector<int16_t, int32_t>;
+        EXPECT_EQ((mpl::contains<zunary_op_types, int16_to_int32>::value), bool(ZARRAY_ENABLE_INT16 && ZARRAY_ENABLE_INT32));
+
+        // disabled types are not registered
+        zarray_impl_register::init();
+        EXPECT_EQ(ztyped_array<int32_t>::get_class_static_index() != SIZE_MAX, bool(ZARRAY_ENABLE_INT32));
+        EXPECT_NE(ztyped_array<bool>::get_class_static_index(), SIZE_MAX);
+    }
+
+    TEST(zarray, metadata)
+    {
+        std::string s = (xtl::endianness() == xtl::endian::little_endian) ? "<" : ">";
+        xarray<double> a = {1., 2.};
+        zarray z(a);
+        zarray z2(z);
+        EXPECT_EQ(z2.get_metadata()["data_type"], s + "f8");
+
+        nlohmann::json metadata;
+        metadata["foo"] = "bar";
+        z.set_metadata(metadata);
+        zarray z3(z);
+        EXPECT_EQ(z3.get_metadata()["foo"], "bar");
+        EXPECT_EQ(z2.get_metadata().count("foo"), 0u);
+    }
+
+    TEST(zarray, metadata_threads)
+    {
+        std::string s = (xtl::endianness() == xtl::endian::little_endian) ? "<" : ">";
+        xarray<double> a = {1., 2.};
+        zarray z(a);
+
+        // the first accesses race to build the metadata
+        std::vector<const nlohmann::json*> results(4u, nullptr);
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            threads.emplace_back([&z, &results, i]() { results[i] = &(z.get_metadata()); });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        for (const auto* r : results)
+        {
+            EXPECT_EQ(r, &(z.get_metadata()));
+        }
+        EXPECT_EQ(z.get_metadata()["data_type"], s + "f8");
+    }
 }
 
 TEST_SUITE_END(); // end of testsuite gm
\ No newline at end of file
@@ -36,18 +36,27 @@ namespace xt
         shape_type shape = {10, 10, 10};
         shape_type chunk_shape = {2, 3, 4};
         auto a = chunked_array<double>(shape, chunk_shape);
+        xarray<double> b = arange(1000.).reshape({10, 10, 10});
         zarray za(a);
 
         auto it = a.chunk_cbegin();
         auto it_end = a.chunk_cend();
         auto zit = za.as_chunked_array().chunk_begin();
-        
+        auto zit_end = za.as_chunked_array().chunk_end();
+
+        std::size_t index = 0;
         while(it != it_end)
         {
-            const auto& tmp = zit.get_xchunked_iterator<decltype(it)>();
-            EXPECT_EQ(tmp, it);
-            ++it, ++zit;
+            EXPECT_EQ(zit.chunk_index(), index);
+            xarray<double> expected = strided_view(b, it.get_slice_vector());
+            xarray<double> res = strided_view(b, zit.get_slice_vector());
+            EXPECT_EQ(res, expected);
+            auto zit2 = zit;
+            EXPECT_EQ(zit2, zit);
+            ++it, ++zit, ++index;
         }
+        EXPECT_EQ(zit, zit_end);
+        EXPECT_EQ(index, za.as_chunked_array().grid_size());
     }
 
     TEST(zchunked_array, custom_metadata)
@@ -162,6 +171,793 @@ namespace xt
 
         EXPECT_EQ(a1, a2);
     }
+
+    TEST(zchunked_array, fill_value)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+        zdispatcher_t<detail::xmove_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 5};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        zarray za(a);
+
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        ca.set_fill_value(3.);
+        EXPECT_TRUE(ca.has_fill_value());
+        for (std::size_t i = 0; i < ca.grid_size(); ++i)
+        {
+            EXPECT_TRUE(ca.is_fill_chunk(i));
+        }
+
+        auto expected = xarray<double>::from_shape(shape);
+        expected.fill(3.);
+        EXPECT_EQ(za.get_array<double>(), expected);
+
+        auto b = xarray<double>::from_shape(shape);
+        std::iota(b.begin(), b.end(), 0.);
+        zarray zb(b);
+        za = zb;
+        EXPECT_FALSE(ca.is_fill_chunk(0));
+        EXPECT_EQ(za.get_array<double>(), b);
+        EXPECT_EQ(a, b);
+    }
+
+    TEST(zchunked_array, fill_value_kernel)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 5};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = chunked_array<double>(shape, chunk_shape);
+        auto res = chunked_array<double>(shape, chunk_shape);
+        zarray za(a);
+        zarray zb(b);
+        zarray zres(res);
+
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        auto& cb = dynamic_cast<ztyped_chunked_array<double>&>(zb.get_implementation());
+        auto& cres = dynamic_cast<ztyped_chunked_array<double>&>(zres.get_implementation());
+        ca.set_fill_value(1.);
+        cb.set_fill_value(2.);
+        cres.set_fill_value(0.);
+
+        auto it = cb.chunk_begin();
+        ++it;
+        cb.assign_chunk(xarray<double>({{5., 6.}, {7., 8.}}), it);
+
+        noalias(zres) = za + zb;
+        EXPECT_TRUE(cres.is_fill_chunk(0));
+        EXPECT_EQ(cres.chunk_fill_value(0), 3.);
+        EXPECT_FALSE(cres.is_fill_chunk(1));
+
+        xarray<double> expected = {{3., 3., 6., 7., 3.},
+                                   {3., 3., 8., 9., 3.},
+                                   {3., 3., 3., 3., 3.},
+                                   {3., 3., 3., 3., 3.}};
+        EXPECT_EQ(zres.get_array<double>(), expected);
+    }
+
+    TEST(zchunked_array, fill_value_reducer)
+    {
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 5};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        zarray za(a);
+
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        ca.set_fill_value(2.);
+        auto it = ca.chunk_begin();
+        ++it;
+        ca.assign_chunk(xarray<double>({{5., 6.}, {7., 8.}}), it);
+
+        zarray zsum = zt::sum(za);
+        EXPECT_EQ(zsum.get_array<double>()(), 58.);
+
+        zarray zmin = zt::amin(za);
+        EXPECT_EQ(zmin.get_array<double>()(), 2.);
+
+        zarray zmax = zt::amax(za);
+        EXPECT_EQ(zmax.get_array<double>()(), 8.);
+
+        zarray zmean = zt::mean(za);
+        EXPECT_DOUBLE_EQ(zmean.get_array<double>()(), 2.9);
+    }
+
+    TEST(zchunked_array, chunk_statistics)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 5};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = xarray<double>::from_shape(shape);
+        std::iota(b.begin(), b.end(), 0.);
+        zarray za(a);
+        za = b;
+
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        EXPECT_FALSE(ca.has_chunk_statistics());
+        ca.enable_chunk_statistics();
+        EXPECT_TRUE(ca.has_chunk_statistics());
+
+        EXPECT_EQ(ca.chunk_statistics(0).min, 0.);
+        EXPECT_EQ(ca.chunk_statistics(0).max, 6.);
+        EXPECT_EQ(ca.chunk_statistics(0).null_count, 0u);
+        EXPECT_EQ(ca.chunk_statistics(2).min, 4.);
+        EXPECT_EQ(ca.chunk_statistics(2).max, 9.);
+        EXPECT_EQ(ca.chunk_statistics(2).size, 2u);
+
+        double nan = std::numeric_limits<double>::quiet_NaN();
+        auto it = ca.chunk_begin();
+        ++it;
+        ca.assign_chunk(xarray<double>({{nan, 1.}, {-3., nan}}), it);
+        EXPECT_EQ(ca.chunk_statistics(1).min, -3.);
+        EXPECT_EQ(ca.chunk_statistics(1).max, 1.);
+        EXPECT_EQ(ca.chunk_statistics(1).null_count, 2u);
+    }
+
+    TEST(zchunked_array, chunk_statistics_pruning)
+    {
+        zdispatcher_t<detail::greater, 2>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 5};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto res = chunked_array<double>(shape, chunk_shape);
+        auto b = xarray<double>::from_shape(shape);
+        std::iota(b.begin(), b.end(), 0.);
+        zarray za(a);
+        zarray zres(res);
+        za = b;
+
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        auto& cres = dynamic_cast<ztyped_chunked_array<double>&>(zres.get_implementation());
+        ca.enable_chunk_statistics();
+        cres.set_fill_value(0.);
+
+        noalias(zres) = za > 7.5;
+        EXPECT_TRUE(cres.is_fill_chunk(0));
+        EXPECT_EQ(cres.chunk_fill_value(0), 0.);
+        EXPECT_FALSE(cres.is_fill_chunk(1));
+        EXPECT_TRUE(cres.is_fill_chunk(3));
+        EXPECT_EQ(cres.chunk_fill_value(3), 1.);
+
+        xarray<double> expected = b > 7.5;
+        EXPECT_EQ(zres.get_array<double>(), expected);
+
+        zarray zmin = zt::amin(za);
+        EXPECT_EQ(zmin.get_array<double>()(), 0.);
+        zarray zmax = zt::amax(za);
+        EXPECT_EQ(zmax.get_array<double>()(), 19.);
+    }
+
+    TEST(zchunked_array, where_fill_chunks)
+    {
+        zdispatcher_t<detail::conditional_ternary, 3>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 5};
+        shape_type chunk_shape = {2, 2};
+        auto cond = chunked_array<bool>(shape, chunk_shape);
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = chunked_array<double>(shape, chunk_shape);
+        auto res = chunked_array<double>(shape, chunk_shape);
+        zarray zcond(cond);
+        zarray za(a);
+        zarray zb(b);
+        zarray zres(res);
+
+        auto& ccond = dynamic_cast<ztyped_chunked_array<bool>&>(zcond.get_implementation());
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        auto& cb = dynamic_cast<ztyped_chunked_array<double>&>(zb.get_implementation());
+        auto& cres = dynamic_cast<ztyped_chunked_array<double>&>(zres.get_implementation());
+        ccond.set_fill_value(true);
+        ca.set_fill_value(1.);
+        cb.set_fill_value(2.);
+        cres.set_fill_value(0.);
+
+        // chunk 1: the condition is not constant
+        auto it = ccond.chunk_begin();
+        ++it;
+        ccond.assign_chunk(xarray<bool>({{true, false}, {false, true}}), it);
+        // chunk 2: the unselected branch is not constant
+        it = cb.chunk_begin();
+        ++it;
+        ++it;
+        xarray<double> b_chunk = xarray<double>::from_shape({2, 1});
+        b_chunk(0, 0) = 5.;
+        b_chunk(1, 0) = 6.;
+        cb.assign_chunk(std::move(b_chunk), it);
+        // chunk 3: the selected branch is not constant
+        it = ca.chunk_begin();
+        ++it;
+        ++it;
+        ++it;
+        ca.assign_chunk(xarray<double>({{3., 4.}, {5., 6.}}), it);
+
+        noalias(zres) = xt::where(zcond, za, zb);
+        EXPECT_TRUE(cres.is_fill_chunk(0));
+        EXPECT_EQ(cres.chunk_fill_value(0), 1.);
+        EXPECT_FALSE(cres.is_fill_chunk(1));
+        EXPECT_TRUE(cres.is_fill_chunk(2));
+        EXPECT_EQ(cres.chunk_fill_value(2), 1.);
+        EXPECT_FALSE(cres.is_fill_chunk(3));
+        // chunk 4: all inputs are fill chunks
+        EXPECT_TRUE(cres.is_fill_chunk(4));
+        EXPECT_EQ(cres.chunk_fill_value(4), 1.);
+
+        xarray<double> expected = {{1., 1., 1., 2., 1.},
+                                   {1., 1., 2., 1., 1.},
+                                   {3., 4., 1., 1., 1.},
+                                   {5., 6., 1., 1., 1.}};
+        EXPECT_EQ(zres.get_array<double>(), expected);
+    }
+
+    TEST(zchunked_array, where_chunk_statistics)
+    {
+        zdispatcher_t<detail::conditional_ternary, 3>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 4};
+        shape_type chunk_shape = {2, 2};
+        auto cond = chunked_array<bool>(shape, chunk_shape);
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = chunked_array<double>(shape, chunk_shape);
+        auto res = chunked_array<double>(shape, chunk_shape);
+        xarray<bool> vcond = {{true, true, false, false},
+                              {true, true, false, false},
+                              {true, false, true, true},
+                              {false, true, true, true}};
+        auto vb = xarray<double>::from_shape(shape);
+        std::iota(vb.begin(), vb.end(), 0.);
+        zarray zcond(cond);
+        zarray za(a);
+        zarray zb(b);
+        zarray zres(res);
+        zcond = vcond;
+        zb = vb;
+
+        auto& ccond = dynamic_cast<ztyped_chunked_array<bool>&>(zcond.get_implementation());
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        auto& cres = dynamic_cast<ztyped_chunked_array<double>&>(zres.get_implementation());
+        ccond.enable_chunk_statistics();
+        ca.set_fill_value(-1.);
+        cres.set_fill_value(0.);
+
+        noalias(zres) = xt::where(zcond, za, zb);
+        // chunks 0 and 3 are all true: the fill chunk of a is selected
+        EXPECT_TRUE(cres.is_fill_chunk(0));
+        EXPECT_EQ(cres.chunk_fill_value(0), -1.);
+        EXPECT_TRUE(cres.is_fill_chunk(3));
+        // chunk 1 is all false: the chunk of b is copied
+        EXPECT_FALSE(cres.is_fill_chunk(1));
+        EXPECT_FALSE(cres.is_fill_chunk(2));
+
+        xarray<double> expected = {{-1., -1., 2., 3.},
+                                   {-1., -1., 6., 7.},
+                                   {-1., 9., -1., -1.},
+                                   {12., -1., -1., -1.}};
+        EXPECT_EQ(zres.get_array<double>(), expected);
+    }
+
+    TEST(zchunked_array, chunked_view)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 6};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = xarray<double>::from_shape(shape);
+        std::iota(b.begin(), b.end(), 0.);
+        zarray za(a);
+        za = b;
+
+        xstrided_slice_vector sv1({range(1, 3), range(2, 5)});
+        zarray zv1 = strided_view(za, sv1);
+        EXPECT_TRUE(zv1.get_implementation().is_chunked());
+        EXPECT_EQ(zv1.as_chunked_array().grid_size(), 4u);
+        xarray<double> expected1 = xt::strided_view(b, sv1);
+        EXPECT_EQ(zv1.get_array<double>(), expected1);
+
+        xstrided_slice_vector sv2({2, range(1, 5)});
+        zarray zv2 = strided_view(za, sv2);
+        EXPECT_EQ(zv2.dimension(), 1u);
+        EXPECT_EQ(zv2.as_chunked_array().grid_size(), 3u);
+        xarray<double> expected2 = xt::strided_view(b, sv2);
+        EXPECT_EQ(zv2.get_array<double>(), expected2);
+    }
+
+    TEST(zchunked_array, assign_chunked_view)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 6};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = xarray<double>::from_shape(shape);
+        std::iota(b.begin(), b.end(), 0.);
+        zarray za(a);
+        za = b;
+
+        xstrided_slice_vector sv({range(1, 3), range(2, 5)});
+        xarray<double> c = {{-1., -2., -3.}, {-4., -5., -6.}};
+        strided_view(za, sv) = c;
+        xt::strided_view(b, sv) = c;
+        EXPECT_EQ(a, b);
+    }
+
+    TEST(zchunked_array, rechunk_plan)
+    {
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {6, 8};
+        shape_type source_chunk_shape = {3, 2};
+        shape_type target_chunk_shape = {2, 3};
+
+        auto plan = make_rechunk_plan(shape, source_chunk_shape, target_chunk_shape, 1000u);
+        EXPECT_EQ(plan.block_shape, shape_type({6, 6}));
+        EXPECT_EQ(plan.source_reads, 1u);
+
+        // a block, a source chunk and a target chunk
+        auto small_plan = make_rechunk_plan(shape, source_chunk_shape, target_chunk_shape, 18u);
+        EXPECT_EQ(small_plan.block_shape, target_chunk_shape);
+        EXPECT_EQ(small_plan.source_reads, 4u);
+
+        EXPECT_THROW(make_rechunk_plan(shape, source_chunk_shape, target_chunk_shape, 17u), std::runtime_error);
+
+        // both rechunks through the intermediate shape read each chunk
+        // once with blocks of a single chunk
+        shape_type intermediate_chunk_shape = rechunk_intermediate_shape(source_chunk_shape, target_chunk_shape);
+        EXPECT_EQ(intermediate_chunk_shape, shape_type({1, 1}));
+        auto plan1 = make_rechunk_plan(shape, source_chunk_shape, intermediate_chunk_shape, 13u);
+        EXPECT_EQ(plan1.block_shape, source_chunk_shape);
+        EXPECT_EQ(plan1.source_reads, 1u);
+        auto plan2 = make_rechunk_plan(shape, intermediate_chunk_shape, target_chunk_shape, 13u);
+        EXPECT_EQ(plan2.block_shape, target_chunk_shape);
+        EXPECT_EQ(plan2.source_reads, 1u);
+
+        EXPECT_EQ(rechunk_intermediate_shape(shape_type({2}), shape_type({3})), shape_type({1}));
+        EXPECT_EQ(rechunk_intermediate_shape(shape_type({2, 6}), shape_type({4, 3})), shape_type({2, 3}));
+    }
+
+    TEST(zchunked_array, rechunk)
+    {
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {6, 8};
+        shape_type source_chunk_shape = {3, 2};
+        shape_type target_chunk_shape = {2, 3};
+        shape_type intermediate_chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, source_chunk_shape);
+        auto b = xarray<double>::from_shape(shape);
+        std::iota(b.begin(), b.end(), 0.);
+        a = b;
+        zarray za(a);
+
+        auto res1 = chunked_array<double>(shape, target_chunk_shape);
+        zarray zres1(res1);
+        rechunk(za, zres1, 1000u);
+        EXPECT_EQ(res1, b);
+
+        auto res2 = chunked_array<double>(shape, target_chunk_shape);
+        zarray zres2(res2);
+        rechunk(za, zres2, 18u);
+        EXPECT_EQ(res2, b);
+
+        auto tmp = chunked_array<double>(shape, intermediate_chunk_shape);
+        auto res3 = chunked_array<double>(shape, target_chunk_shape);
+        zarray ztmp(tmp);
+        zarray zres3(res3);
+        rechunk(za, ztmp, zres3, 18u);
+        EXPECT_EQ(res3, b);
+    }
+
+    TEST(zchunked_array, chunk_version)
+    {
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 4};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = chunked_array<double>(shape, chunk_shape);
+        zarray za(a);
+        zarray zb(b);
+
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        auto& cb = dynamic_cast<ztyped_chunked_array<double>&>(zb.get_implementation());
+        EXPECT_NE(ca.chunk_version(0), cb.chunk_version(0));
+
+        std::size_t version = ca.chunk_version(1);
+        auto it = ca.chunk_begin();
+        ++it;
+        ca.assign_chunk(xarray<double>({{1., 2.}, {3., 4.}}), it);
+        EXPECT_NE(ca.chunk_version(1), version);
+        EXPECT_EQ(ca.chunk_version(0), version);
+    }
+
+    TEST(zchunked_array, incremental_assign)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 4};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = chunked_array<double>(shape, chunk_shape);
+        auto res = chunked_array<double>(shape, chunk_shape);
+        auto values = xarray<double>::from_shape(shape);
+        std::iota(values.begin(), values.end(), 0.);
+        a = values;
+        b = values;
+        zarray za(a);
+        zarray zb(b);
+        zarray zres(res);
+
+        auto& ca = dynamic_cast<ztyped_chunked_array<double>&>(za.get_implementation());
+        auto& cres = dynamic_cast<ztyped_chunked_array<double>&>(zres.get_implementation());
+        cres.set_incremental(true);
+
+        noalias(zres) = za + zb;
+        EXPECT_EQ(res, values + values);
+
+        std::vector<std::size_t> versions(cres.grid_size());
+        for (std::size_t i = 0; i < versions.size(); ++i)
+        {
+            versions[i] = cres.chunk_version(i);
+        }
+
+        // Nothing has changed, no chunk is recomputed
+        noalias(zres) = za + zb;
+        for (std::size_t i = 0; i < versions.size(); ++i)
+        {
+            EXPECT_EQ(cres.chunk_version(i), versions[i]);
+        }
+
+        auto it = ca.chunk_begin();
+        ++it;
+        ca.assign_chunk(xarray<double>({{0., 0.}, {0., 0.}}), it);
+        noalias(zres) = za + zb;
+        EXPECT_NE(cres.chunk_version(1), versions[1]);
+        for (std::size_t i = 0; i < versions.size(); ++i)
+        {
+            if (i != 1)
+            {
+                EXPECT_EQ(cres.chunk_version(i), versions[i]);
+            }
+        }
+        EXPECT_EQ(res, a + b);
+
+        // A different expression recomputes every chunk
+        noalias(zres) = za + 1.;
+        EXPECT_EQ(res, a + 1.);
+        noalias(zres) = za + 2.;
+        EXPECT_EQ(res, a + 2.);
+    }
+
+    TEST(zchunked_array, pipelined_assign)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::multiplies, 2>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {5, 4};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = chunked_array<double>(shape, chunk_shape);
+        auto c = xarray<double>::from_shape(shape);
+        std::iota(c.begin(), c.end(), 0.);
+        a = c;
+        b = c + 1.;
+        zarray za(a);
+        zarray zb(b);
+        zarray zc(c);
+
+        auto res = chunked_array<double>(shape, chunk_shape);
+        zarray zres(res);
+        pipelined_assign(zres, za + zb * 2., 1);
+        EXPECT_EQ(res, a + b * 2.);
+
+        shape_type other_chunk_shape = {3, 3};
+        auto res2 = chunked_array<double>(shape, other_chunk_shape);
+        zarray zres2(res2);
+        pipelined_assign(zres2, za * zc + zb, 3);
+        EXPECT_EQ(res2, a * c + b);
+    }
+
+    TEST(zchunked_array, traversal_order)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+        zdispatcher_t<detail::plus, 2>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {8, 8};
+        shape_type chunk_shape = {2, 2};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        zarray za(a);
+        zchunked_array& ca = za.as_chunked_array();
+        EXPECT_EQ(ca.traversal_order(), zchunk_traversal::row_major);
+
+        auto visit = [&ca]()
+        {
+            std::vector<std::size_t> res;
+            for (auto it = ca.chunk_begin(); it != ca.chunk_end(); ++it)
+            {
+                res.push_back(it.chunk_index());
+            }
+            return res;
+        };
+
+        ca.set_traversal_order(zchunk_traversal::morton);
+        std::vector<std::size_t> morton = visit();
+        std::vector<std::size_t> expected_morton = {0, 1, 4, 5, 2, 3, 6, 7, 8, 9, 12, 13, 10, 11, 14, 15};
+        EXPECT_EQ(morton, expected_morton);
+
+        // Consecutive chunks of a Hilbert traversal are neighbours
+        ca.set_traversal_order(zchunk_traversal::hilbert);
+        std::size_t count = 0;
+        zchunked_iterator prev = ca.chunk_begin();
+        for (auto it = ca.chunk_begin(); it != ca.chunk_end(); ++it, ++count)
+        {
+            if (count != 0)
+            {
+                std::size_t dist = 0;
+                for (std::size_t d = 0; d < 2; ++d)
+                {
+                    std::size_t c0 = prev.chunk_coords()[d];
+                    std::size_t c1 = it.chunk_coords()[d];
+                    dist += c0 > c1 ? c0 - c1 : c1 - c0;
+                }
+                EXPECT_EQ(dist, 1u);
+            }
+            prev = it;
+        }
+        EXPECT_EQ(count, ca.grid_size());
+
+        // Every chunk is visited once on grids that are not powers of two
+        shape_type shape2 = {10, 10, 10};
+        shape_type chunk_shape2 = {2, 3, 4};
+        auto b = chunked_array<double>(shape2, chunk_shape2);
+        zarray zb(b);
+        zchunked_array& cb = zb.as_chunked_array();
+        cb.set_traversal_order(zchunk_traversal::hilbert);
+        std::vector<std::size_t> indices;
+        for (auto it = cb.chunk_begin(); it != cb.chunk_end(); ++it)
+        {
+            indices.push_back(it.chunk_index());
+        }
+        std::sort(indices.begin(), indices.end());
+        std::vector<std::size_t> expected_indices(cb.grid_size());
+        std::iota(expected_indices.begin(), expected_indices.end(), std::size_t(0));
+        EXPECT_EQ(indices, expected_indices);
+
+        auto c = xarray<double>::from_shape(shape2);
+        std::iota(c.begin(), c.end(), 0.);
+        zarray zc(c);
+        noalias(zb) = zc + zc;
+        EXPECT_EQ(b, c + c);
+
+        auto res = chunked_array<double>(shape2, shape_type({3, 3, 3}));
+        zarray zres(res);
+        zres.as_chunked_array().set_traversal_order(zchunk_traversal::morton);
+        rechunk(zb, zres, 1000u);
+        EXPECT_EQ(res, c + c);
+    }
+
+    TEST(zchunked_array, traversal_order_elongated)
+    {
+        // Elongated grids only visit their own chunks, not the
+        // power-of-two bounding grid of the curve
+        auto check = [](const zchunk_grid& grid)
+        {
+            for (auto order : {zchunk_traversal::morton, zchunk_traversal::hilbert})
+            {
+                zchunk_grid g(grid);
+                g.set_traversal(order);
+                std::vector<std::size_t> indices;
+                auto end = zchunked_iterator(g, g.size());
+                for (auto it = zchunked_iterator(g, 0u); it != end; ++it)
+                {
+                    EXPECT_EQ(g.chunk_index(it.chunk_coords()), it.chunk_index());
+                    indices.push_back(it.chunk_index());
+                }
+                std::sort(indices.begin(), indices.end());
+                std::vector<std::size_t> expected(g.size());
+                std::iota(expected.begin(), expected.end(), std::size_t(0));
+                EXPECT_EQ(indices, expected);
+            }
+        };
+
+        using shape_type = zarray::shape_type;
+        check(zchunk_grid(shape_type({1000, 1}), shape_type({1, 1})));
+        check(zchunk_grid(shape_type({3, 257, 1}), shape_type({1, 1, 1})));
+        check(zchunk_grid(shape_type({1, 1 << 20}), shape_type({1, 1})));
+
+        // An iterator built on a chunk resumes the traversal from it
+        zchunk_grid grid(shape_type({3, 257, 1}), shape_type({1, 1, 1}));
+        grid.set_traversal(zchunk_traversal::morton);
+        auto it = zchunked_iterator(grid, 0u);
+        for (std::size_t i = 0; i < 100u; ++i)
+        {
+            ++it;
+        }
+        auto it2 = zchunked_iterator(grid, it.chunk_index());
+        ++it;
+        ++it2;
+        EXPECT_EQ(it.chunk_index(), it2.chunk_index());
+    }
+
+    TEST(zchunked_array, traversal_order_resize)
+    {
+        // A grid grown in place visits its chunks in the order of a
+        // grid built with the final shape
+        using shape_type = zarray::shape_type;
+        auto check = [](std::size_t dim, zchunk_traversal order)
+        {
+            shape_type shape = {5, 3};
+            shape[dim] = 0;
+            shape_type chunk_shape = {1, 1};
+            zchunk_grid grid(shape, chunk_shape);
+            grid.set_traversal(order);
+            for (std::size_t extent : {2u, 3u, 4u, 9u, 11u, 6u})
+            {
+                grid.resize(dim, extent);
+                shape[dim] = extent;
+                zchunk_grid expected(shape, chunk_shape);
+                expected.set_traversal(order);
+                EXPECT_EQ(grid.grid_shape(), expected.grid_shape());
+                EXPECT_EQ(grid.size(), expected.size());
+                for (std::size_t r = 0; r < grid.size(); ++r)
+                {
+                    EXPECT_EQ(grid.traversal_chunk(r), expected.traversal_chunk(r));
+                    EXPECT_EQ(grid.traversal_rank(r), expected.traversal_rank(r));
+                }
+            }
+        };
+        for (auto order : {zchunk_traversal::row_major, zchunk_traversal::morton, zchunk_traversal::hilbert})
+        {
+            check(0u, order);
+            check(1u, order);
+        }
+    }
+
+    TEST(zchunked_array, appendable)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+        zdispatcher_t<detail::plus, 2>::init();
+        zappend_dispatcher::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {0, 3};
+        shape_type chunk_shape = {2, 2};
+        zarray za = appendable_chunked_array<double>(shape, chunk_shape);
+        EXPECT_TRUE(za.get_implementation().is_chunked());
+        EXPECT_EQ(za.as_chunked_array().grid_size(), 0u);
+
+        xarray<double> a0 = {{0., 1., 2.}, {3., 4., 5.}};
+        xarray<double> a1 = {{6., 7., 8.}};
+        append(za, zarray(a0));
+        EXPECT_EQ(za.shape(), shape_type({2, 3}));
+        EXPECT_EQ(za.as_chunked_array().grid_size(), 2u);
+        EXPECT_EQ(za.get_array<double>(), a0);
+
+        // Appending only touches the trailing chunks
+        std::size_t version0 = za.as_chunked_array().chunk_version(0);
+        append(za, zarray(a1));
+        EXPECT_EQ(za.as_chunked_array().chunk_version(0), version0);
+        xarray<double> expected = {{0., 1., 2.}, {3., 4., 5.}, {6., 7., 8.}};
+        EXPECT_EQ(za.get_array<double>(), expected);
+
+        // Expressions and reducers run over the current extent, the
+        // appendable result follows the extent of the inputs
+        zarray zres = appendable_chunked_array<double>(shape, chunk_shape);
+        zres.as_chunked_array().set_incremental(true);
+        noalias(zres) = za + za;
+        EXPECT_EQ(zres.get_array<double>(), expected + expected);
+        zarray zsum = zt::sum(za);
+        EXPECT_EQ(zsum.get_array<double>()(), 36.);
+
+        xarray<int> a2 = {{9, 10, 11}, {12, 13, 14}};
+        append(za, zarray(a2));
+        std::size_t res_version0 = zres.as_chunked_array().chunk_version(0);
+        noalias(zres) = za + za;
+        xarray<double> expected2 = {{0., 1., 2.}, {3., 4., 5.}, {6., 7., 8.}, {9., 10., 11.}, {12., 13., 14.}};
+        EXPECT_EQ(zres.get_array<double>(), expected2 + expected2);
+        EXPECT_EQ(zres.as_chunked_array().chunk_version(0), res_version0);
+
+        xarray<double> bad = {{1., 2.}};
+        EXPECT_THROW(append(za, zarray(bad)), std::runtime_error);
+        zarray zdense(a0);
+        EXPECT_THROW(append(zdense, zarray(a1)), std::runtime_error);
+
+        // Growing along the last axis
+        shape_type shape2 = {3, 0};
+        zarray zb = appendable_chunked_array<double>(shape2, chunk_shape, 1u);
+        xarray<double> b0 = {0., 1., 2.};
+        b0.reshape({3, 1});
+        xarray<double> b1 = {{3., 4.}, {5., 6.}, {7., 8.}};
+        append(zb, zarray(b0));
+        append(zb, zarray(b1));
+        xarray<double> expected3 = {{0., 3., 4.}, {1., 5., 6.}, {2., 7., 8.}};
+        EXPECT_EQ(zb.get_array<double>(), expected3);
+
+        // A grid too large for the traversal order leaves the array unchanged
+        shape_type shape3 = {1, 1, 1, 1, 1, 1, 1, 0};
+        shape_type chunk_shape3 = {1, 1, 1, 1, 1, 1, 1, 1};
+        zarray zc = appendable_chunked_array<double>(shape3, chunk_shape3, 7u);
+        zc.as_chunked_array().set_traversal_order(zchunk_traversal::morton);
+        xarray<double> c0 = xarray<double>::from_shape({1, 1, 1, 1, 1, 1, 1, 128});
+        std::iota(c0.begin(), c0.end(), 0.);
+        append(zc, zarray(c0));
+        EXPECT_EQ(zc.get_array<double>(), c0);
+        xarray<double> c1 = xarray<double>::from_shape({1, 1, 1, 1, 1, 1, 1, 1});
+        EXPECT_THROW(append(zc, zarray(c1)), std::runtime_error);
+        EXPECT_EQ(zc.shape(), shape_type({1, 1, 1, 1, 1, 1, 1, 128}));
+        EXPECT_EQ(zc.as_chunked_array().grid_size(), 128u);
+        EXPECT_EQ(zc.get_array<double>(), c0);
+    }
+
+    TEST(zchunked_array, chunked_result)
+    {
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+        zdispatcher_t<detail::plus, 2>::init();
+
+        using shape_type =  zarray::shape_type;
+        shape_type shape = {4, 6};
+        shape_type chunk_shape = {2, 3};
+        auto a = chunked_array<double>(shape, chunk_shape);
+        auto b = xarray<double>::from_shape(shape);
+        std::iota(b.begin(), b.end(), 0.);
+        a = b;
+        zarray za(a);
+        zarray zb(b);
+
+        // The result of a function follows its chunked operands
+        zarray zres = zb + za;
+        EXPECT_TRUE(zres.get_implementation().is_chunked());
+        EXPECT_EQ(zres.as_chunked_array().chunk_shape(), chunk_shape);
+        EXPECT_EQ(zres.get_array<double>(), b + b);
+
+        zarray zdense = zb + zb;
+        EXPECT_FALSE(zdense.get_implementation().is_chunked());
+
+        // Partial reductions keep the chunks of the remaining axes
+        zarray zsum = zt::sum(za, {0});
+        EXPECT_TRUE(zsum.get_implementation().is_chunked());
+        EXPECT_EQ(zsum.as_chunked_array().chunk_shape(), shape_type({3}));
+        xarray<double> expected_sum = xt::sum(b, {0});
+        EXPECT_EQ(zsum.get_array<double>(), expected_sum);
+
+        zarray zsum_keep = zt::sum(za, {1}, keep_dims);
+        EXPECT_EQ(zsum_keep.as_chunked_array().chunk_shape(), shape_type({2, 1}));
+        xarray<double> expected_sum_keep = xt::sum(b, {1}, keep_dims);
+        EXPECT_EQ(zsum_keep.get_array<double>(), expected_sum_keep);
+
+        // Boxes spanning several chunks are read from these chunks only
+        const auto& ta = static_cast<const ztyped_array<double>&>(za.get_implementation());
+        xstrided_slice_vector box = {xt::range(1, 4), xt::range(2, 5)};
+        EXPECT_EQ(ta.get_chunk(box), xarray<double>(xt::strided_view(b, box)));
+
+        zarray ztotal = zt::sum(za);
+        EXPECT_FALSE(ztotal.get_implementation().is_chunked());
+
+        // User-supplied chunk shape
+        shape_type other_chunk_shape = {3, 3};
+        zarray zeval = zt::eval_chunked(zb + zb, other_chunk_shape);
+        EXPECT_EQ(zeval.as_chunked_array().chunk_shape(), other_chunk_shape);
+        EXPECT_EQ(zeval.get_array<double>(), b + b);
+    }
 }
 
 TEST_SUITE_END(); 
\ No newline at end of file
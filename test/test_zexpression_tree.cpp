@@ -215,6 +215,99 @@ namespace xt
         }
     }
 
+    TEST_CASE("reuse_temporary_operands")
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+
+        xarray<float> x0 = {{1.f, 2.f}, {3.f, 4.f}};
+        xarray<float> x1 = {{5.f, 6.f}, {7.f, 8.f}};
+
+        zarray z0(x0);
+        zarray z1(x1);
+
+        // the buffers of the temporary operands hold the intermediate
+        // results when they are adopted by the pool
+        auto func = (zarray(xarray<float>(x0)) + z1) + (zarray(xarray<float>(x1)) + z0);
+
+        auto res = xarray<float>::from_shape({2,2});
+        zarray zres(res);
+        detail::zarray_temporary_pool temporary_pool(zres.get_implementation());
+        detail::adopt_temporary_operands(func, temporary_pool);
+
+        zassign_args assign_args;
+        auto& r = func.assign_to(temporary_pool, assign_args);
+        CHECK_EQ(temporary_pool.size(), 0);
+        CHECK_EQ(&r, &(zres.get_implementation()));
+
+        xarray<float> expected = {{12.f, 16.f}, {20.f, 24.f}};
+        CHECK_EQ(res, expected);
+    }
+
+    TEST_CASE("evaluate_twice")
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::xassign_dummy_functor, 1>::init();
+
+        xarray<float> x0 = {{1.f, 2.f}, {3.f, 4.f}};
+        xarray<float> x1 = {{5.f, 6.f}, {7.f, 8.f}};
+
+        zarray z0(x0);
+        zarray z1(x1);
+
+        xarray<float> expected = {{12.f, 16.f}, {20.f, 24.f}};
+
+        // an expression that is not a temporary keeps its operands
+        auto func = (zarray(xarray<float>(x0)) + z1) + (zarray(xarray<float>(x1)) + z0);
+        zarray r1 = func;
+        zarray r2 = func;
+        CHECK_EQ(r1.get_array<float>(), expected);
+        CHECK_EQ(r2.get_array<float>(), expected);
+
+        // a temporary expression is consumed
+        zarray r3 = (zarray(xarray<float>(x0)) + z1) + (zarray(xarray<float>(x1)) + z0);
+        CHECK_EQ(r3.get_array<float>(), expected);
+        zarray r4 = std::move(func);
+        CHECK_EQ(r4.get_array<float>(), expected);
+
+        // lazy arrays
+        zarray l = zt::lazy((zarray(xarray<float>(x0)) + z1) + (zarray(xarray<float>(x1)) + z0));
+        zarray r5 = l + z0;
+        zarray r6 = l + z0;
+        CHECK_EQ(r5.get_array<float>(), expected + x0);
+        CHECK_EQ(r6.get_array<float>(), expected + x0);
+    }
+
+    TEST_CASE("common_subexpressions")
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::minus, 2>::init();
+        zdispatcher_t<detail::multiplies, 2>::init();
+        zdispatcher_t<math::sqrt_fun, 1>::init();
+
+        xarray<double> a = {{5., 6.}, {7., 8.}};
+        xarray<double> b = {{1., 2.}, {3., 4.}};
+
+        zarray za(a);
+        zarray zb(b);
+
+        // za - zb is evaluated once for its three occurrences
+        auto func = (za - zb) * (za - zb) + sqrt(za - zb);
+
+        auto res = xarray<double>::from_shape({2,2});
+        zarray zres(res);
+        detail::zarray_temporary_pool temporary_pool(zres.get_implementation());
+        detail::count_subexpressions(func, temporary_pool);
+        CHECK_EQ(temporary_pool.common_subexpression_count(), 1);
+
+        zassign_args assign_args;
+        auto& r = func.assign_to(temporary_pool, assign_args);
+        CHECK_EQ(temporary_pool.size(), 1);
+        CHECK_EQ(&r, &(zres.get_implementation()));
+
+        xarray<double> expected = {{18., 18.}, {18., 18.}};
+        CHECK_EQ(res, expected);
+    }
+
     TEST_CASE("test_casting_order")
     {
         zdispatcher_t<detail::plus, 2>::init();  
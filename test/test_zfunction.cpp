@@ -1,5 +1,7 @@
 #include "test_common.hpp"
 
+#include <cmath>
+
 #include <zarray/zarray.hpp>
 #include <xtl/xplatform.hpp>
 #include <xtl/xhalf_float.hpp>
@@ -125,6 +127,146 @@ namespace xt
         EXPECT_EQ(zres.get_array<double>(), expected);
     }
 
+    TEST(zfunction, scalar_operands)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::minus, 2>::init();
+        zdispatcher_t<detail::multiplies, 2>::init();
+
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        zarray za(a);
+
+        zscalar_wrapper<xscalar<double>> s(xscalar<double>(2.));
+        EXPECT_EQ(s.dimension(), 0u);
+        EXPECT_EQ(*(s.scalar_value()), 2.);
+
+        // writes through the array are seen by the kernels
+        s.get_array()() = 3.;
+        EXPECT_EQ(*(s.scalar_value()), 3.);
+        EXPECT_EQ(s.get_chunk({})(), 3.);
+        std::unique_ptr<zscalar_wrapper<xscalar<double>>> c(s.clone());
+        EXPECT_EQ(*(c->scalar_value()), 3.);
+
+        auto f = 10. - za * 2. + 1.;
+        zarray zres(f);
+        xarray<double> expected = {{9., 7.}, {5., 3.}};
+        EXPECT_EQ(zres.get_array<double>(), expected);
+    }
+
+    TEST(zfunction, scalar_rewrites)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::multiplies, 2>::init();
+
+        xarray<int> a = {{1, 2}, {3, 4}};
+        xarray<double> b = {{1., 2.}, {3., 4.}};
+        zarray za(a);
+        zarray zb(b);
+
+        // folded into za * 24
+        auto f1 = 2 * (za * 3) * 4;
+        using f1_operand_type = std::decay_t<decltype(std::get<0>(f1.arguments()))>;
+        EXPECT_TRUE((detail::zfoldable_chain<detail::multiplies, f1_operand_type, int>::value));
+        zarray zres1(f1);
+        xarray<int> expected1 = {{24, 48}, {72, 96}};
+        EXPECT_EQ(zres1.get_array<int>(), expected1);
+
+        // identity operations are dropped
+        auto f2 = (zb * 2. + zb) * 1.;
+        zarray zres2(f2);
+        xarray<double> expected2 = {{3., 6.}, {9., 12.}};
+        EXPECT_EQ(zres2.get_array<double>(), expected2);
+
+        // floating point chains are not reassociated
+        auto f3 = zb * 2. * 3.;
+        using f3_operand_type = std::decay_t<decltype(std::get<0>(f3.arguments()))>;
+        EXPECT_EQ((detail::zfoldable_chain<detail::multiplies, f3_operand_type, double>::value), bool(ZARRAY_FAST_MATH));
+        zarray zres3(f3);
+        xarray<double> expected3 = {{6., 12.}, {18., 24.}};
+        EXPECT_EQ(zres3.get_array<double>(), expected3);
+    }
+
+    TEST(zfunction, scalar_rewrites_promoted)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::plus, 2>::insert<int32_t, uint8_t, int32_t>();
+
+        xarray<uint8_t> a = {{1, 2}, {3, 4}};
+        zarray za(a);
+
+        // uint8_t + uint8_t is promoted to int32_t, the scalars must
+        // not be folded in uint8_t
+        auto f = (za + uint8_t(200)) + uint8_t(200);
+        EXPECT_EQ(f.get_result_type_index(), ztyped_array<int32_t>::get_class_static_index());
+        zarray zres(f);
+        xarray<int32_t> expected = {{401, 402}, {403, 404}};
+        EXPECT_EQ(zres.get_array<int32_t>(), expected);
+    }
+
+    TEST(zfunction, ternary_functions)
+    {
+        zdispatcher_t<math::fma_fun, 3>::init();
+        zdispatcher_t<math::clamp_fun, 3>::init();
+        zdispatcher_t<detail::conditional_ternary, 3>::init();
+
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        xarray<double> b = {{5., 6.}, {7., 8.}};
+        xarray<double> c = {{0.5, 1.5}, {2.5, 3.5}};
+        xarray<bool> cond = {{true, false}, {false, true}};
+        zarray za(a);
+        zarray zb(b);
+        zarray zc(c);
+        zarray zcond(cond);
+
+        zarray zres1 = xt::fma(za, zb, zc);
+        xarray<double> expected1 = {{5.5, 13.5}, {23.5, 35.5}};
+        EXPECT_EQ(zres1.get_array<double>(), expected1);
+
+        auto f2 = xt::clip(za, 2., 3.);
+        zarray zres2(f2);
+        xarray<double> expected2 = {{2., 2.}, {3., 3.}};
+        EXPECT_EQ(zres2.get_array<double>(), expected2);
+
+        zarray zres3 = xt::where(zcond, za, zb);
+        xarray<double> expected3 = {{1., 6.}, {7., 4.}};
+        EXPECT_EQ(zres3.get_array<double>(), expected3);
+
+        zarray zres4 = zc + za * zb;
+        EXPECT_EQ(zres4.get_array<double>(), expected1);
+    }
+
+    TEST(zfunction, fp_contract)
+    {
+        zdispatcher_t<math::fma_fun, 3>::init();
+        zdispatcher_t<detail::plus, 2>::init();
+        zdispatcher_t<detail::multiplies, 2>::init();
+
+        // a * b = 1 - 2^-60 is rounded to 1 before the addition
+        // unless a * b + c is evaluated by the fma kernel
+        double eps = std::ldexp(1., -30);
+        xarray<double> a = {1. + eps, 1. + eps};
+        xarray<double> b = {1. - eps, 1. - eps};
+        xarray<double> c = {-1., -1.};
+        zarray za(a);
+        zarray zb(b);
+        zarray zc(c);
+
+        zarray zres1 = za * zb + zc;
+        zarray zres2 = zc + za * zb;
+#if ZARRAY_FP_CONTRACT
+        xarray<double> expected = {-eps * eps, -eps * eps};
+#else
+        xarray<double> expected = {0., 0.};
+#endif
+        EXPECT_EQ(zres1.get_array<double>(), expected);
+        EXPECT_EQ(zres2.get_array<double>(), expected);
+
+        // xt::fma is always fused
+        zarray zres3 = xt::fma(za, zb, zc);
+        xarray<double> expected3 = {-eps * eps, -eps * eps};
+        EXPECT_EQ(zres3.get_array<double>(), expected3);
+    }
+
     TEST(zfunction, broadcasting)
     {
         using add_dispatcher_type = zdispatcher_t<detail::plus, 2>;
@@ -141,6 +283,56 @@ namespace xt
         EXPECT_EQ(zres.get_array<double>(), expected);
     }
 
+    TEST(zfunction, broadcast_kernels)
+    {
+        zdispatcher_t<detail::minus, 2>::init();
+        zdispatcher_t<detail::multiplies, 2>::init();
+        zdispatcher_t<detail::divides, 2>::init();
+
+        xarray<double> a = {{1., 2., 3.}, {4., 5., 6.}};
+        xarray<double> row = {1., 2., 3.};
+        xarray<double> column = {2., 4.};
+        column.reshape({2, 1});
+        zarray za(a);
+        zarray zrow(row);
+        zarray zcolumn(column);
+
+        xarray<double> expected1 = a - row;
+        zarray zres1 = za - zrow;
+        EXPECT_EQ(zres1.get_array<double>(), expected1);
+
+        xarray<double> expected2 = a / column;
+        zarray zres2 = za / zcolumn;
+        EXPECT_EQ(zres2.get_array<double>(), expected2);
+
+        xarray<double> expected3 = column - row;
+        zarray zres3 = zcolumn - zrow;
+        EXPECT_EQ(zres3.get_array<double>(), expected3);
+
+        // the scalar is broadcast in a non-trivial broadcast
+        xarray<double> expected4 = (a - row) * 2.;
+        auto f4 = (za - zrow) * 2.;
+        zarray zres4(f4);
+        EXPECT_EQ(zres4.get_array<double>(), expected4);
+    }
+
+    TEST(zfunction, op_families)
+    {
+        EXPECT_EQ((init_zdispatchers<ZARRAY_ASSIGN_OPS | ZARRAY_ARITHMETIC_OPS>()), 0);
+
+        xarray<double> a = {{1., 4.}, {9., 16.}};
+        zarray za(a);
+
+        zarray zres1 = za + za;
+        xarray<double> expected1 = {{2., 8.}, {18., 32.}};
+        EXPECT_EQ(zres1.get_array<double>(), expected1);
+
+        // the dispatcher of sqrt is built on its first dispatch
+        zarray zres2 = xt::sqrt(za);
+        xarray<double> expected2 = {{1., 2.}, {3., 4.}};
+        EXPECT_EQ(zres2.get_array<double>(), expected2);
+    }
+
     TEST(zfunction, math_operator_extended)
     {
         using add_dispatcher_type = zdispatcher_t<detail::plus, 2>;
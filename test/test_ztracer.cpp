@@ -0,0 +1,96 @@
+/***************************************************************************
+* Copyright (c) Johan Mabille, Sylvain Corlay and Wolf Vollprecht          *
+* Copyright (c) QuantStack                                                 *
+*                                                                          *
+* Distributed under the terms of the BSD 3-Clause License.                 *
+*                                                                          *
+* The full license is in the file LICENSE, distributed with this software. *
+****************************************************************************/
+
+#include "test_common.hpp"
+
+#include <sstream>
+
+#include "zarray/zarray.hpp"
+#include "zarray/ztracer.hpp"
+
+TEST_SUITE_BEGIN("ztracer");
+
+namespace xt
+{
+    TEST(ztracer, scope)
+    {
+        ztracer& tracer = ztracer::instance();
+        tracer.clear();
+
+        // nothing is recorded while the tracer is disabled
+        {
+            ztrace_scope trace("test", []() { return std::string("disabled"); });
+            EXPECT_FALSE(trace.is_active());
+        }
+        EXPECT_EQ(tracer.size(), 0u);
+
+        tracer.enable();
+        {
+            ztrace_scope trace("test", []() { return std::string("enabled"); });
+            EXPECT_TRUE(trace.is_active());
+            trace.args()["value"] = 2;
+        }
+        tracer.disable();
+        EXPECT_EQ(tracer.size(), 2u);
+
+        nlohmann::json events = tracer.to_json()["traceEvents"];
+        EXPECT_EQ(events.size(), 2u);
+        EXPECT_EQ(events[0]["name"], "enabled");
+        EXPECT_EQ(events[0]["cat"], "test");
+        EXPECT_EQ(events[0]["ph"], "B");
+        EXPECT_EQ(events[1]["ph"], "E");
+        EXPECT_EQ(events[1]["args"]["value"], 2);
+        EXPECT_LE(events[0]["ts"].get<double>(), events[1]["ts"].get<double>());
+
+        std::ostringstream out;
+        tracer.write(out);
+        EXPECT_EQ(nlohmann::json::parse(out.str()), tracer.to_json());
+
+        tracer.clear();
+        EXPECT_EQ(tracer.size(), 0u);
+    }
+
+    TEST(ztracer, type_name)
+    {
+        EXPECT_EQ(detail::ztrace_type_name<detail::plus>(), "plus");
+        EXPECT_EQ(detail::ztrace_type_name<zsum_zreducer_functor>(), "zsum_zreducer_functor");
+    }
+
+    // Run by test_ztracer_enabled, built with ZARRAY_TRACING
+#if ZARRAY_TRACING
+    TEST(ztracer, kernels)
+    {
+        zdispatcher_t<detail::plus, 2>::init();
+
+        xarray<double> a = {{1., 2.}, {3., 4.}};
+        zarray za(a);
+
+        ztracer& tracer = ztracer::instance();
+        tracer.clear();
+        tracer.enable();
+        zarray zres = za + za;
+        tracer.disable();
+
+        bool found = false;
+        for (const auto& e : tracer.to_json()["traceEvents"])
+        {
+            if (e["cat"] == "kernel" && e["name"] == "plus" && e["ph"] == "E")
+            {
+                found = true;
+                EXPECT_EQ(e["args"]["output"], zarray_impl_register::data_type(ztyped_array<double>::get_class_static_index()));
+                EXPECT_EQ(e["args"]["bytes"], 3u * 4u * sizeof(double));
+            }
+        }
+        EXPECT_TRUE(found);
+        tracer.clear();
+    }
+#endif
+}
+
+TEST_SUITE_END();